@@ -0,0 +1,352 @@
+/**
+ * Check the feedback kernels against a reference, and time them.
+ * The reference is the original is_possible check of an answer against a guess and its outcome, kept here unchanged
+ * apart from taking letters as alphabet indexes, along with a plain count-based statement of the Wordle rule.
+ * usage: bench_feedback [--exhaustive] [--first-guess FILE] [word options], see print_usage.
+ */
+
+#include "dictionary.c"
+#include "feedback.c"
+
+#define OUTPUT_FILE "first_guess.txt" // the golden output of first_guess.c
+#define PATTERN_STRIDE 64             // check every pattern against every answer for every PATTERN_STRIDE-th guess
+#define BENCH_STRIDE 16               // time the kernels on every BENCH_STRIDE-th guess against every answer
+#define BENCH_MIN_SECONDS 0.2         // repeat each timing until it takes at least this long
+
+/**
+ * Get the number of times a letter appears in a word.
+ * @param letters The letters of the word.
+ * @param length The number of letters in the word.
+ * @param letter The letter to look for.
+ * @return The number of times the letter appears.
+ */
+int count_letter(unsigned char *letters, int length, int letter)
+{
+    int count = 0;
+    for (int i = 0; i < length; i++)
+        count += letters[i] == letter;
+    return count;
+}
+
+/**
+ * Check if an answer is possible, given a guess and its outcome, as the solver first did: the greens of the outcome are
+ * checked, then the oranges, then the blacks, counting how many of each letter were checked so far.
+ * @param list The word list.
+ * @param answer The letters of the answer.
+ * @param guess The letters of the guess.
+ * @param outcome The outcome, one GREEN, ORANGE or BLACK per letter.
+ * @return Boolean indicating whether the answer is possible.
+ */
+bool is_possible(struct word_list *list, unsigned char *answer, unsigned char *guess, int outcome[MAX_WORD_LENGTH])
+{
+    int checked[MAX_ALPHABET_SIZE] = {}; // the number of each letter checked so far
+    for (int colour = GREEN; colour >= BLACK; colour--)
+    {
+        for (int index = 0; index < list->length; index++)
+        {
+            if (outcome[index] != colour)
+                continue;
+            int count = count_letter(answer, list->length, guess[index]);
+            if (colour == GREEN)
+            {
+                if (answer[index] != guess[index]) // answer must contain the letter at the index
+                    return false;
+                checked[guess[index]]++;
+            }
+            else if (colour == ORANGE)
+            {
+                // the answer must contain more of the letter than were checked, and not at this index
+                if (checked[guess[index]] == count || guess[index] == answer[index])
+                    return false;
+                checked[guess[index]]++;
+            }
+            else if (count != 0 && checked[guess[index]] < count) // a black means every one of the letter was checked
+                return false;
+        }
+    }
+    return true; // answer passes validation
+}
+
+/**
+ * Get the outcome Wordle gives, counting rather than matching letters: letter i is green if it is in place, and
+ * otherwise orange if the answer has more of the letter outside of its greens than the guess has oranges of it before i.
+ * @param list The word list.
+ * @param guess The letters of the guess.
+ * @param answer The letters of the answer.
+ * @param outcome The array to store the outcome in, one GREEN, ORANGE or BLACK per letter.
+ */
+void get_reference_outcome(struct word_list *list, unsigned char *guess, unsigned char *answer, int outcome[MAX_WORD_LENGTH])
+{
+    for (int i = 0; i < list->length; i++)
+    {
+        if (guess[i] == answer[i])
+        {
+            outcome[i] = GREEN;
+            continue;
+        }
+        int unmatched = 0; // the answer's letters outside of its greens
+        for (int j = 0; j < list->length; j++)
+            unmatched += answer[j] == guess[i] && guess[j] != answer[j];
+        int earlier = 0; // the oranges already given to the letter
+        for (int j = 0; j < i; j++)
+            earlier += outcome[j] == ORANGE && guess[j] == guess[i];
+        outcome[i] = unmatched > earlier ? ORANGE : BLACK;
+    }
+}
+
+/**
+ * Get the outcome of an outcome code.
+ * @param list The word list.
+ * @param code The outcome code.
+ * @param outcome The array to store the outcome in, one GREEN, ORANGE or BLACK per letter.
+ */
+void get_outcome_of_code(struct word_list *list, int code, int outcome[MAX_WORD_LENGTH])
+{
+    for (int i = list->length - 1; i >= 0; i--) // the first letter is the most significant digit
+    {
+        outcome[i] = code % OUTCOMES_LENGTH;
+        code /= OUTCOMES_LENGTH;
+    }
+}
+
+/**
+ * Check every kernel against the reference for every guess against every answer, and every outcome against the answers
+ * of every PATTERN_STRIDE-th guess (or every guess when exhaustive).
+ * @param list The word list and its feedback matrix.
+ * @param exhaustive Boolean indicating whether to check every outcome for every guess.
+ * @return The number of mismatches.
+ */
+long check_kernels(struct word_list *list, bool exhaustive)
+{
+    long mismatches = 0, pairs = 0, patterns = 0, impossible = 0;
+    for (int guess = 0; guess < list->guess_count; guess++)
+    {
+        unsigned char *guess_letters = get_letters(list, guess);
+        for (int answer = 0; answer < list->answer_count; answer++)
+        {
+            unsigned char *answer_letters = get_letters(list, answer);
+            int outcome[MAX_WORD_LENGTH];
+            get_reference_outcome(list, guess_letters, answer_letters, outcome);
+            int code = get_outcome_code(list, outcome);
+            int kernel = get_feedback(list, guess_letters, answer_letters);
+            int matrix = get_outcome(list, guess, answer);
+            bool possible = is_possible(list, answer_letters, guess_letters, outcome);
+            if (kernel != code || matrix != code || !possible)
+            {
+                if (mismatches++ < 10)
+                    printf("** MISMATCH: %s against %s - reference %d, get_feedback %d, matrix %d, is_possible %d **\n",
+                           get_word(list, guess), get_word(list, answer), code, kernel, matrix, possible);
+            }
+            pairs++;
+        }
+
+        if (!exhaustive && guess % PATTERN_STRIDE != 0)
+            continue;
+        for (int code = 0; code < list->outcome_count; code++) // the matrix keeps only answers is_possible accepts
+        {
+            int outcome[MAX_WORD_LENGTH];
+            get_outcome_of_code(list, code, outcome);
+            for (int answer = 0; answer < list->answer_count; answer++)
+            {
+                bool possible = is_possible(list, get_letters(list, answer), guess_letters, outcome);
+                bool kept = get_outcome(list, guess, answer) == code;
+                if (kept && !possible && mismatches++ < 10)
+                    printf("** MISMATCH: %s against %s - outcome %d kept but not possible **\n", get_word(list, guess), get_word(list, answer), code);
+                impossible += possible && !kept;
+            }
+            patterns++;
+        }
+    }
+    printf("checked %ld guess/answer pairs and %ld guess/outcome patterns: %ld mismatches\n", pairs, patterns, mismatches);
+    printf("  (%ld answers pass is_possible for an outcome Wordle wouldn't give them, which filtering by outcome code never keeps)\n", impossible);
+    return mismatches;
+}
+
+/**
+ * Check first_guess.txt, the end to end golden output, against the scores of every first guess.
+ * @param list The word list and its feedback matrix.
+ * @param file_name The golden file.
+ * @return The number of mismatched lines, or 1 if the file couldn't be read, so a missing golden file fails the check.
+ */
+long check_first_guesses(struct word_list *list, char *file_name)
+{
+    FILE *f = fopen(file_name, "r");
+    if (f == NULL)
+    {
+        printf("** ERROR: could not read %s **\n", file_name);
+        return 1;
+    }
+
+    unsigned long long answer_set[list->set_words];
+    fill_set(list, answer_set);
+    long mismatches = 0, lines = 0;
+    double previous = 0;
+    char line[MAX_WORD_LENGTH * MAX_LETTER_SIZE + 32], word[MAX_WORD_LENGTH * MAX_LETTER_SIZE + 1], expected[sizeof(line)];
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        line[strcspn(line, "\n")] = '\0';
+        lines++;
+        int index = sscanf(line, "%50s", word) == 1 ? find_word(list, word) : NULL_INDEX;
+        double score = index == NULL_INDEX ? 0 : score_guess(list, index, answer_set);
+        snprintf(expected, sizeof(expected), "%s - %5.2lf", index == NULL_INDEX ? "?" : get_word(list, index), score);
+        if (index == NULL_INDEX || strcmp(line, expected) != 0 || score < previous) // the file is in ascending order of score
+        {
+            if (mismatches++ < 10)
+                printf("** MISMATCH: %s line %ld is '%s', expected '%s' **\n", file_name, lines, line, expected);
+        }
+        previous = score;
+    }
+    fclose(f);
+    if (lines != list->guess_count && mismatches++ < 10)
+        printf("** MISMATCH: %s has %ld lines, expected %d **\n", file_name, lines, list->guess_count);
+    printf("checked %ld first guesses of %s: %ld mismatches\n", lines, file_name, mismatches);
+    return mismatches;
+}
+
+/**
+ * Get the current time.
+ * @return The time in seconds from an arbitrary fixed point.
+ */
+double get_time()
+{
+    return (double)get_nanoseconds() / (1000.0 * NANOSECONDS_PER_MS);
+}
+
+/**
+ * The kernels timed.
+ */
+enum kernel
+{
+    KERNEL_IS_POSSIBLE, // is_possible of the true outcome
+    KERNEL_REFERENCE,   // get_reference_outcome
+    KERNEL_FEEDBACK,    // get_feedback from the letters
+    KERNEL_MATRIX,      // get_outcome from the feedback matrix
+    KERNEL_SCORE,       // score_guess, per answer bucketed
+    KERNELS
+};
+
+/**
+ * Run a kernel on every BENCH_STRIDE-th guess against every answer once.
+ * @param list The word list and its feedback matrix.
+ * @param kernel The kernel.
+ * @param outcomes The outcome of each guess timed against each answer, for is_possible.
+ * @param answer_set The set of every answer.
+ * @return A value depending on every result, so that none of the work can be left out.
+ */
+long run_kernel(struct word_list *list, enum kernel kernel, int (*outcomes)[MAX_WORD_LENGTH], unsigned long long *answer_set)
+{
+    long sum = 0;
+    for (int guess = 0, row = 0; guess < list->guess_count; guess += BENCH_STRIDE, row++)
+    {
+        unsigned char *guess_letters = get_letters(list, guess);
+        if (kernel == KERNEL_SCORE)
+        {
+            sum += (long)score_guess(list, guess, answer_set);
+            continue;
+        }
+        for (int answer = 0; answer < list->answer_count; answer++)
+        {
+            unsigned char *answer_letters = get_letters(list, answer);
+            if (kernel == KERNEL_IS_POSSIBLE)
+                sum += is_possible(list, answer_letters, guess_letters, outcomes[(size_t)row * list->answer_count + answer]);
+            else if (kernel == KERNEL_REFERENCE)
+            {
+                int outcome[MAX_WORD_LENGTH];
+                get_reference_outcome(list, guess_letters, answer_letters, outcome);
+                sum += outcome[0];
+            }
+            else if (kernel == KERNEL_FEEDBACK)
+                sum += get_feedback(list, guess_letters, answer_letters);
+            else
+                sum += get_outcome(list, guess, answer);
+        }
+    }
+    return sum;
+}
+
+/**
+ * Time every kernel on every BENCH_STRIDE-th guess against every answer, and print ns/op and throughput.
+ * @param list The word list and its feedback matrix.
+ */
+void bench_kernels(struct word_list *list)
+{
+    const char *names[KERNELS] = {"is_possible", "reference outcome", "get_feedback", "feedback matrix", "score_guess"};
+    int rows = (list->guess_count + BENCH_STRIDE - 1) / BENCH_STRIDE;
+    int (*outcomes)[MAX_WORD_LENGTH] = malloc(sizeof(*outcomes) * rows * list->answer_count);
+    for (int guess = 0, row = 0; guess < list->guess_count; guess += BENCH_STRIDE, row++)
+    {
+        for (int answer = 0; answer < list->answer_count; answer++)
+            get_outcome_of_code(list, get_outcome(list, guess, answer), outcomes[(size_t)row * list->answer_count + answer]);
+    }
+    unsigned long long answer_set[list->set_words];
+    fill_set(list, answer_set);
+
+    long ops = (long)rows * list->answer_count; // one op is one guess against one answer
+    printf("%-18s %12s %10s %12s\n", "kernel", "ops", "ns/op", "Mops/s");
+    long sink = 0;
+    for (int kernel = 0; kernel < KERNELS; kernel++)
+    {
+        long rounds = 0;
+        double start = get_time(), elapsed;
+        do
+        {
+            sink += run_kernel(list, kernel, outcomes, answer_set);
+            rounds++;
+            elapsed = get_time() - start;
+        } while (elapsed < BENCH_MIN_SECONDS);
+        double per_op = elapsed / (rounds * ops);
+        printf("%-18s %12ld %10.2lf %12.1lf\n", names[kernel], rounds * ops, per_op * 1e9, 1e-6 / per_op);
+    }
+    printf("(checksum %ld)\n", sink);
+    free(outcomes);
+}
+
+/**
+ * Print how to run the program.
+ * @param program The name of the program.
+ */
+void print_usage(char *program)
+{
+    printf("usage: %s [--exhaustive] [--first-guess FILE] [--answer-list FILE] [--guess-list FILE] [--dictionary FILE]\n", program);
+    printf("  --exhaustive        check every outcome against the answers for every guess, not every %dth guess\n", PATTERN_STRIDE);
+    printf("  --first-guess FILE  the golden first guess ranking to check (default: %s)\n", OUTPUT_FILE);
+    printf("  --answer-list FILE  the answers, one per line (default: %s)\n", ANSWERS_FILE);
+    printf("  --guess-list FILE   the guesses that aren't answers, one per line (default: %s)\n", GUESSES_FILE);
+    printf("  --dictionary FILE   the packed dictionary, used instead of the lists when it is newer (default: %s)\n", DICTIONARY_FILE);
+}
+
+int main(int argc, char *argv[])
+{
+    bool exhaustive = false;
+    char *first_guess_file = OUTPUT_FILE, *answer_list = NULL, *guess_list = NULL, *dictionary = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--exhaustive") == 0)
+            exhaustive = true;
+        else if (strcmp(argv[i], "--first-guess") == 0 && has_value)
+            first_guess_file = argv[++i];
+        else if (strcmp(argv[i], "--answer-list") == 0 && has_value)
+            answer_list = argv[++i];
+        else if (strcmp(argv[i], "--guess-list") == 0 && has_value)
+            guess_list = argv[++i];
+        else if (strcmp(argv[i], "--dictionary") == 0 && has_value)
+            dictionary = argv[++i];
+        else
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    choose_word_files(&answer_list, &guess_list, &dictionary);
+    struct word_list list;
+    if (!load_word_list(&list, answer_list, guess_list, dictionary)) // get answers and guesses
+        return 1;
+    get_feedback_matrix(&list); // get the outcome of every guess against every answer
+
+    long mismatches = check_kernels(&list, exhaustive) + check_first_guesses(&list, first_guess_file);
+    bench_kernels(&list);
+    free_word_list(&list);
+    return mismatches > 0;
+}
@@ -0,0 +1,133 @@
+/**
+ * Sets of answers stored as bitsets, bit i of the set is whether answer i is in the set.
+ * A set is set_words words of the word list, so it is declared as unsigned long long set[list->set_words].
+ * A set of guesses (in hard mode) is the same with guess_set_words words, bit i is whether guess i is in the set.
+ * Filtering a set by a result only visits the answers in it (keep_outcome in feedback.c) and counting it is a popcount.
+ */
+
+#ifndef BITSET_C
+#define BITSET_C
+
+#include "shared.c"
+
+#define WORD_BITS 64 // the number of bits in each word of a bitset
+
+/**
+ * Get the number of words in a set of answers.
+ * @param answer_count The number of answers.
+ * @return The number of words.
+ */
+int get_set_words(int answer_count)
+{
+    return (answer_count + WORD_BITS - 1) / WORD_BITS;
+}
+
+/**
+ * Fill a set with every answer.
+ * @param list The word list.
+ * @param set The set to fill.
+ */
+void fill_set(struct word_list *list, unsigned long long *set)
+{
+    for (int i = 0; i < list->set_words; i++)
+        set[i] = ~0ULL;
+    if (list->answer_count % WORD_BITS != 0) // bits past the last answer must stay clear
+        set[list->set_words - 1] = (1ULL << (list->answer_count % WORD_BITS)) - 1;
+}
+
+/**
+ * Fill a set of guesses with every guess.
+ * @param list The word list.
+ * @param set The set to fill.
+ */
+void fill_guess_set(struct word_list *list, unsigned long long *set)
+{
+    for (int i = 0; i < list->guess_set_words; i++)
+        set[i] = ~0ULL;
+    if (list->guess_count % WORD_BITS != 0) // bits past the last guess must stay clear
+        set[list->guess_set_words - 1] = (1ULL << (list->guess_count % WORD_BITS)) - 1;
+}
+
+/**
+ * Check whether an answer is in a set.
+ * @param set The set to look in.
+ * @param index The index of the answer.
+ * @return Boolean indicating whether the answer is in the set.
+ */
+bool in_set(unsigned long long *set, int index)
+{
+    return (set[index / WORD_BITS] >> (index % WORD_BITS)) & 1;
+}
+
+/**
+ * Count the answers in a set.
+ * @param list The word list.
+ * @param set The set to count.
+ * @return The number of answers in the set.
+ */
+int count_set(struct word_list *list, unsigned long long *set)
+{
+    int count = 0;
+    for (int i = 0; i < list->set_words; i++)
+        count += __builtin_popcountll(set[i]);
+    return count;
+}
+
+/**
+ * Get the first answer in a set.
+ * @param list The word list.
+ * @param set The set to look in.
+ * @return The index of the first answer in the set, or NULL_INDEX if the set is empty.
+ */
+int first_in_set(struct word_list *list, unsigned long long *set)
+{
+    for (int i = 0; i < list->set_words; i++)
+    {
+        if (set[i] != 0)
+            return i * WORD_BITS + __builtin_ctzll(set[i]);
+    }
+    return NULL_INDEX;
+}
+
+/**
+ * Get the next answer in a set.
+ * @param list The word list.
+ * @param set The set to look in.
+ * @param index The index of the current answer.
+ * @return The index of the first answer in the set after index, or NULL_INDEX if there is none.
+ */
+int next_in_set(struct word_list *list, unsigned long long *set, int index)
+{
+    index++;
+    int i = index / WORD_BITS;
+    if (i >= list->set_words)
+        return NULL_INDEX;
+
+    unsigned long long bits = set[i] & (~0ULL << (index % WORD_BITS)); // answers from index onwards in this word
+    while (bits == 0)
+    {
+        if (++i == list->set_words)
+            return NULL_INDEX;
+        bits = set[i];
+    }
+    return i * WORD_BITS + __builtin_ctzll(bits);
+}
+
+/**
+ * Hash a set.
+ * @param list The word list.
+ * @param set The set to hash.
+ * @return A 64-bit hash of the answers in the set.
+ */
+unsigned long long hash_set(struct word_list *list, unsigned long long *set)
+{
+    unsigned long long hash = 0;
+    for (int i = 0; i < list->set_words; i++)
+    {
+        hash = (hash ^ set[i]) * 0x9E3779B97F4A7C15ULL; // multiply by the 64-bit golden ratio to mix each word in
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+#endif
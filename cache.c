@@ -0,0 +1,273 @@
+/**
+ * A bounded cache of the best guess for each set of available answers, so repeated game states cost a lookup instead of a search.
+ * Entries are found by a hash of the set and checked against the whole set, and are evicted by the CLOCK algorithm.
+ * The cache can be saved to and loaded from a file between runs.
+ */
+
+#ifndef CACHE_C
+#define CACHE_C
+
+#include <pthread.h>
+#include <stdlib.h>
+#include "feedback.c"
+
+#define CACHE_MAGIC "WRDLBGC1"   // identifies a best guess cache file
+#define BYTES_PER_MB (1 << 20)
+
+/**
+ * A cached best guess.
+ */
+struct cache_entry
+{
+    unsigned long long key;         // hash_set of the answers
+    int guess;                      // the index of the best guess for these answers
+    int next;                       // the next entry in the same hash bucket, or NULL_INDEX
+    bool referenced;                // whether the entry was used since the clock hand last passed it
+    unsigned long long answer_set[]; // the available answers
+};
+
+/**
+ * The header at the start of a best guess cache file, followed by the (answer_set, guess) of each entry.
+ */
+struct cache_header
+{
+    char magic[FEEDBACK_MAGIC_LENGTH]; // CACHE_MAGIC
+    int version;                       // STRATEGY_VERSION
+    int count;                         // the number of entries
+    unsigned long long checksum;       // checksum of the words the entries were found with
+};
+
+/**
+ * A best guess cache, safe to share between threads.
+ */
+struct guess_cache
+{
+    struct word_list *list;
+    char *entries;     // the entries, entry_size bytes each
+    size_t entry_size; // the size of an entry, including its set of answers
+    int capacity;      // the most entries the memory budget allows
+    int count;         // the number of entries in use
+    int hand;          // the clock hand, the next entry considered for eviction
+    int *buckets;      // the first entry in each hash bucket, or NULL_INDEX
+    int bucket_mask;   // the number of buckets - 1, the number of buckets is a power of 2
+    long hits;         // lookups that found an entry
+    long misses;       // lookups that didn't
+    long evictions;    // entries replaced to make room
+    pthread_mutex_t lock;
+};
+
+/**
+ * Get an entry of a cache.
+ * @param cache The cache.
+ * @param index The index of the entry.
+ * @return The entry.
+ */
+struct cache_entry *get_cache_entry(struct guess_cache *cache, int index)
+{
+    return (struct cache_entry *)(cache->entries + index * cache->entry_size);
+}
+
+/**
+ * Set up an empty cache.
+ * @param cache The cache to set up.
+ * @param list The word list of the sets of answers cached.
+ * @param budget The most memory the cache may use, in bytes. A budget too small for any entry disables the cache.
+ */
+void init_cache(struct guess_cache *cache, struct word_list *list, size_t budget)
+{
+    memset(cache, 0, sizeof(*cache));
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->list = list;
+    cache->entry_size = sizeof(struct cache_entry) + sizeof(unsigned long long) * list->set_words;
+    cache->entry_size = (cache->entry_size + sizeof(unsigned long long) - 1) / sizeof(unsigned long long) * sizeof(unsigned long long);
+
+    size_t capacity = budget / (cache->entry_size + 2 * sizeof(int)); // each entry needs up to 2 buckets
+    int buckets = 1;
+    while ((size_t)buckets < capacity && buckets < (1 << 30))
+        buckets *= 2;
+    cache->capacity = capacity < (size_t)buckets ? (int)capacity : buckets;
+    if (cache->capacity == 0)
+        return;
+
+    cache->entries = malloc(cache->entry_size * cache->capacity);
+    cache->buckets = malloc(sizeof(int) * buckets);
+    if (cache->entries == NULL || cache->buckets == NULL)
+    {
+        free(cache->entries);
+        free(cache->buckets);
+        cache->entries = NULL;
+        cache->buckets = NULL;
+        cache->capacity = 0;
+        return;
+    }
+    cache->bucket_mask = buckets - 1;
+    for (int i = 0; i < buckets; i++)
+        cache->buckets[i] = NULL_INDEX;
+}
+
+/**
+ * Release a cache.
+ * @param cache The cache to release.
+ */
+void free_cache(struct guess_cache *cache)
+{
+    free(cache->entries);
+    free(cache->buckets);
+    pthread_mutex_destroy(&cache->lock);
+    memset(cache, 0, sizeof(*cache));
+}
+
+/**
+ * Find the entry for a set of answers, the cache must be locked.
+ * @param cache The cache.
+ * @param key hash_set of the answers.
+ * @param answer_set The available answers.
+ * @return The index of the entry, or NULL_INDEX if there is none.
+ */
+int find_cache_entry(struct guess_cache *cache, unsigned long long key, unsigned long long *answer_set)
+{
+    for (int i = cache->buckets[key & cache->bucket_mask]; i != NULL_INDEX; i = get_cache_entry(cache, i)->next)
+    {
+        struct cache_entry *entry = get_cache_entry(cache, i);
+        if (entry->key == key && memcmp(entry->answer_set, answer_set, sizeof(unsigned long long) * cache->list->set_words) == 0)
+            return i;
+    }
+    return NULL_INDEX;
+}
+
+/**
+ * Look up the best guess for a set of answers.
+ * @param cache The cache, which may be NULL.
+ * @param answer_set The available answers.
+ * @return The index of the cached best guess, or NULL_INDEX if it isn't cached.
+ */
+int cache_lookup(struct guess_cache *cache, unsigned long long *answer_set)
+{
+    if (cache == NULL || cache->capacity == 0)
+        return NULL_INDEX;
+
+    unsigned long long key = hash_set(cache->list, answer_set);
+    pthread_mutex_lock(&cache->lock);
+    int entry = find_cache_entry(cache, key, answer_set);
+    int guess = NULL_INDEX;
+    if (entry == NULL_INDEX)
+        cache->misses++;
+    else
+    {
+        cache->hits++;
+        get_cache_entry(cache, entry)->referenced = true;
+        guess = get_cache_entry(cache, entry)->guess;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return guess;
+}
+
+/**
+ * Choose an entry to replace with the clock algorithm and remove it from its bucket, the cache must be locked and full.
+ * @param cache The cache.
+ * @return The index of the entry.
+ */
+int evict_cache_entry(struct guess_cache *cache)
+{
+    while (get_cache_entry(cache, cache->hand)->referenced) // give recently used entries a second chance
+    {
+        get_cache_entry(cache, cache->hand)->referenced = false;
+        cache->hand = (cache->hand + 1) % cache->capacity;
+    }
+    int victim = cache->hand;
+    cache->hand = (cache->hand + 1) % cache->capacity;
+
+    int *link = &cache->buckets[get_cache_entry(cache, victim)->key & cache->bucket_mask];
+    while (*link != victim)
+        link = &get_cache_entry(cache, *link)->next;
+    *link = get_cache_entry(cache, victim)->next;
+    cache->evictions++;
+    return victim;
+}
+
+/**
+ * Store the best guess for a set of answers.
+ * @param cache The cache, which may be NULL.
+ * @param answer_set The available answers.
+ * @param guess The index of the best guess.
+ */
+void cache_insert(struct guess_cache *cache, unsigned long long *answer_set, int guess)
+{
+    if (cache == NULL || cache->capacity == 0)
+        return;
+
+    unsigned long long key = hash_set(cache->list, answer_set);
+    pthread_mutex_lock(&cache->lock);
+    if (find_cache_entry(cache, key, answer_set) == NULL_INDEX) // another thread may have got here first
+    {
+        int entry = cache->count < cache->capacity ? cache->count++ : evict_cache_entry(cache);
+        struct cache_entry *e = get_cache_entry(cache, entry);
+        e->key = key;
+        memcpy(e->answer_set, answer_set, sizeof(unsigned long long) * cache->list->set_words);
+        e->guess = guess;
+        e->referenced = false;
+        e->next = cache->buckets[key & cache->bucket_mask];
+        cache->buckets[key & cache->bucket_mask] = entry;
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
+
+/**
+ * Load the entries saved in a cache file, if it matches the current words and strategy.
+ * Entries whose guess isn't a valid guess index are skipped, as check_tree and check_second_guesses reject bad indexes.
+ * @param cache The cache to add the entries to.
+ * @param file_name The name of the file.
+ * @return The number of entries loaded.
+ */
+int load_cache(struct guess_cache *cache, char *file_name)
+{
+    FILE *f = fopen(file_name, "rb");
+    if (f == NULL)
+        return 0;
+
+    struct cache_header header;
+    int loaded = 0;
+    if (fread(&header, sizeof(header), 1, f) == 1 && memcmp(header.magic, CACHE_MAGIC, FEEDBACK_MAGIC_LENGTH) == 0 &&
+        header.version == STRATEGY_VERSION && header.checksum == cache->list->checksum)
+    {
+        unsigned long long answer_set[cache->list->set_words];
+        int guess;
+        for (int i = 0; i < header.count && fread(answer_set, sizeof(unsigned long long), cache->list->set_words, f) == (size_t)cache->list->set_words && fread(&guess, sizeof(guess), 1, f) == 1; i++)
+        {
+            if (guess < 0 || guess >= cache->list->guess_count) // a corrupt entry, which would index past the words
+                continue;
+            cache_insert(cache, answer_set, guess);
+            loaded++;
+        }
+    }
+    fclose(f);
+    return loaded;
+}
+
+/**
+ * Save every entry of a cache to a file.
+ * @param cache The cache.
+ * @param file_name The name of the file.
+ * @return Boolean indicating whether the cache was saved.
+ */
+bool save_cache(struct guess_cache *cache, char *file_name)
+{
+    FILE *f = fopen(file_name, "wb");
+    if (f == NULL)
+        return false;
+
+    pthread_mutex_lock(&cache->lock);
+    struct cache_header header = {.version = STRATEGY_VERSION, .count = cache->count, .checksum = cache->list->checksum};
+    memcpy(header.magic, CACHE_MAGIC, FEEDBACK_MAGIC_LENGTH);
+    bool saved = fwrite(&header, sizeof(header), 1, f) == 1;
+    for (int i = 0; i < cache->count && saved; i++)
+    {
+        struct cache_entry *entry = get_cache_entry(cache, i);
+        saved = fwrite(entry->answer_set, sizeof(unsigned long long), cache->list->set_words, f) == (size_t)cache->list->set_words &&
+                fwrite(&entry->guess, sizeof(entry->guess), 1, f) == 1;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return fclose(f) == 0 && saved;
+}
+
+#endif
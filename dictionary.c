@@ -0,0 +1,558 @@
+/**
+ * Loading the answers and guesses, as word lists or as a packed binary dictionary, and a constant time index from a word
+ * to its guess.
+ * The number of words, the number of letters in each word and the alphabet are all read from the words themselves, and
+ * every table built from them comes out of one arena sized up front.
+ * In the packed dictionary each word is stored as a code of letter_bits bits per letter (5 for English) with the first
+ * letter most significant, so the codes sort in the same order as the words. The file is memory mapped only while it is
+ * decoded into the word list's arena, so loading it is a bounds check and a decode with no parsing, but each process keeps
+ * its own copy of the words rather than sharing the file's pages.
+ */
+
+#ifndef DICTIONARY_C
+#define DICTIONARY_C
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "feedback.c"
+
+#define DICTIONARY_FILE "words.bin"  // packed dictionary file name
+#define DICTIONARY_MAGIC "WRDLDIC3"  // identifies a packed dictionary file
+#define DICTIONARY_ALIGNMENT 8       // the codes start on a multiple of this many bytes, so each is read aligned
+
+/**
+ * The header at the start of a packed dictionary file, followed by the text of each letter of the alphabet
+ * (MAX_LETTER_SIZE bytes each), zero padding up to get_codes_offset, and then the code of every guess (code_size bytes each).
+ * The guesses start with the answers, so the first answer_count codes are the answers.
+ */
+struct dictionary_header
+{
+    char magic[FEEDBACK_MAGIC_LENGTH]; // DICTIONARY_MAGIC
+    int answer_count;                  // the number of answers
+    int guess_count;                   // the number of guesses, including the answers
+    int length;                        // the number of letters in each word
+    int alphabet_size;                 // the number of letters in the alphabet
+    int letter_bits;                   // the number of bits of each letter in a code
+    int code_size;                     // the bytes of each code, 4 or 8
+    unsigned long long checksum;       // get_words_checksum of the words
+};
+
+/**
+ * The words of a word list file, before they are put in a word list.
+ */
+struct text_words
+{
+    char *buffer; // the contents of the file, one word per line
+    char **words; // the start of each word in the buffer
+    int count;    // the number of words
+};
+
+/**
+ * Set up a word list of the given sizes, allocating every table from one arena.
+ * @param list The word list to set up.
+ * @param answer_count The number of answers.
+ * @param guess_count The number of guesses, including the answers.
+ * @param length The number of letters in each word.
+ * @param alphabet_size The number of letters in the alphabet.
+ * @param letter_size The most bytes of any letter of the alphabet.
+ * @return Boolean indicating whether the sizes are supported and the arena could be allocated.
+ */
+bool init_word_list(struct word_list *list, int answer_count, int guess_count, int length, int alphabet_size, int letter_size)
+{
+    memset(list, 0, sizeof(*list));
+    if (answer_count < 1 || guess_count < answer_count || length < 1 || length > MAX_WORD_LENGTH ||
+        alphabet_size < 1 || alphabet_size > MAX_ALPHABET_SIZE || letter_size < 1 || letter_size >= MAX_LETTER_SIZE)
+        return false;
+
+    list->answer_count = answer_count;
+    list->guess_count = guess_count;
+    list->length = length;
+    list->alphabet_size = alphabet_size;
+    list->letter_bits = 1;
+    while (1 << list->letter_bits < alphabet_size)
+        list->letter_bits++;
+    list->outcome_count = 1;
+    for (int i = 0; i < length; i++)
+        list->outcome_count *= OUTCOMES_LENGTH;
+    list->outcome_size = list->outcome_count <= 256 ? 1 : 2;
+    list->set_words = get_set_words(answer_count);
+    list->guess_set_words = get_set_words(guess_count);
+    list->text_size = length * letter_size + 1;
+    list->slot_mask = 1;
+    while (list->slot_mask < 2 * guess_count) // the word index is never more than half full
+        list->slot_mask *= 2;
+    list->slot_mask--;
+
+    size_t sizes[] = {sizeof(char[MAX_LETTER_SIZE]) * alphabet_size, (size_t)guess_count * length, (size_t)guess_count * list->text_size,
+                      get_feedback_size(list), sizeof(unsigned long long) * guess_count, sizeof(int) * (list->slot_mask + 1)};
+    size_t total = 0;
+    for (int i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++)
+        total += get_arena_size(sizes[i]);
+    if (!init_arena(&list->arena, total))
+        return false;
+
+    list->alphabet = arena_alloc(&list->arena, sizes[0]);
+    list->letters = arena_alloc(&list->arena, sizes[1]);
+    list->text = arena_alloc(&list->arena, sizes[2]);
+    list->feedback = arena_alloc(&list->arena, sizes[3]);
+    list->codes = arena_alloc(&list->arena, sizes[4]);
+    list->slots = arena_alloc(&list->arena, sizes[5]);
+    memset(list->alphabet, 0, sizes[0]);
+    return true;
+}
+
+/**
+ * Release a word list and every table built from it.
+ * @param list The word list to release.
+ */
+void free_word_list(struct word_list *list)
+{
+    free_arena(&list->arena);
+    memset(list, 0, sizeof(*list));
+}
+
+/**
+ * Find the letter at the start of some text, in any case.
+ * @param list The word list, whose alphabet has been indexed.
+ * @param text The text.
+ * @param size Where to store the number of bytes of the letter.
+ * @return The letter, or NULL_INDEX if the text doesn't start with a letter of the alphabet.
+ */
+int find_letter(struct word_list *list, char *text, int *size)
+{
+    *size = get_letter_size(text);
+    if (*size == 1) // the fast path, a single byte letter is a table lookup
+    {
+        char letter = text[0] >= 'A' && text[0] <= 'Z' ? text[0] + 'a' - 'A' : text[0];
+        return list->byte_letters[(unsigned char)letter];
+    }
+    for (int i = 0; i < list->alphabet_size && *size > 0; i++)
+    {
+        if (strncmp(list->alphabet[i], text, *size) == 0 && list->alphabet[i][*size] == '\0')
+            return i;
+    }
+    return NULL_INDEX;
+}
+
+/**
+ * Index the single byte letters of the alphabet, once it is filled in.
+ * @param list The word list.
+ */
+void index_alphabet(struct word_list *list)
+{
+    memset(list->byte_letters, NULL_INDEX, sizeof(list->byte_letters));
+    for (int i = 0; i < list->alphabet_size; i++)
+    {
+        if (strlen(list->alphabet[i]) == 1)
+            list->byte_letters[(unsigned char)list->alphabet[i][0]] = i;
+    }
+}
+
+/**
+ * Get the code of some letters.
+ * @param list The word list.
+ * @param letters The letters of a word.
+ * @return The code, letter i is held in bits letter_bits * (length - 1 - i) upwards.
+ */
+unsigned long long pack_word(struct word_list *list, unsigned char *letters)
+{
+    unsigned long long code = 0;
+    for (int i = 0; i < list->length; i++)
+        code = code << list->letter_bits | letters[i];
+    return code;
+}
+
+/**
+ * Write out a guess from its letters.
+ * @param list The word list.
+ * @param index The index of the guess.
+ */
+void write_word(struct word_list *list, int index)
+{
+    char *text = get_word(list, index);
+    text[0] = '\0';
+    for (int i = 0; i < list->length; i++)
+        strcat(text, list->alphabet[get_letters(list, index)[i]]);
+}
+
+/**
+ * Get the first slot of the word index to look for a code in.
+ * @param list The word list.
+ * @param code The code of a word.
+ * @return The slot, from the code multiplied by the 64-bit golden ratio.
+ */
+int get_word_slot(struct word_list *list, unsigned long long code)
+{
+    return (code * 0x9E3779B97F4A7C15ULL) >> 32 & list->slot_mask;
+}
+
+/**
+ * Finish a word list once its letters are filled in, writing out every word and indexing them.
+ * @param list The word list.
+ */
+void index_words(struct word_list *list)
+{
+    for (int i = 0; i <= list->slot_mask; i++)
+        list->slots[i] = NULL_INDEX;
+    for (int i = 0; i < list->guess_count; i++)
+    {
+        write_word(list, i);
+        list->codes[i] = pack_word(list, get_letters(list, i));
+        int slot = get_word_slot(list, list->codes[i]);
+        while (list->slots[slot] != NULL_INDEX) // linear probing, the table is never more than half full
+            slot = (slot + 1) & list->slot_mask;
+        list->slots[slot] = i;
+    }
+    list->checksum = get_words_checksum(list);
+}
+
+/**
+ * Find a word in the valid guesses.
+ * @param list The word list.
+ * @param word The word to look for, in any case.
+ * @return The index of the word in guesses, or NULL_INDEX if it isn't a valid guess.
+ */
+int find_word(struct word_list *list, char *word)
+{
+    unsigned long long code = 0;
+    for (int i = 0; i < list->length; i++)
+    {
+        int size;
+        int letter = find_letter(list, word, &size);
+        if (letter == NULL_INDEX) // also stops at the end of a short word
+            return NULL_INDEX;
+        code = code << list->letter_bits | letter;
+        word += size;
+    }
+    if (word[0] != '\0')
+        return NULL_INDEX;
+
+    for (int slot = get_word_slot(list, code); list->slots[slot] != NULL_INDEX; slot = (slot + 1) & list->slot_mask)
+    {
+        if (list->codes[list->slots[slot]] == code)
+            return list->slots[slot];
+    }
+    return NULL_INDEX;
+}
+
+/**
+ * Read the words of a word list file, one per line.
+ * @param words Where to store the words.
+ * @param file_name The name of the file.
+ * @return Boolean indicating whether the file could be read.
+ */
+bool read_text_words(struct text_words *words, char *file_name)
+{
+    memset(words, 0, sizeof(*words));
+    FILE *f = fopen(file_name, "rb");
+    if (f == NULL)
+        return false;
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    words->buffer = size >= 0 ? malloc(size + 1) : NULL;
+    bool read = words->buffer != NULL && fread(words->buffer, 1, size, f) == (size_t)size;
+    fclose(f);
+    if (!read)
+    {
+        free(words->buffer);
+        words->buffer = NULL;
+        return false;
+    }
+    words->buffer[size] = '\0';
+
+    int lines = 1;
+    for (long i = 0; i < size; i++)
+        lines += words->buffer[i] == '\n';
+    words->words = malloc(sizeof(char *) * lines);
+    for (char *line = strtok(words->buffer, "\r\n"); line != NULL; line = strtok(NULL, "\r\n")) // blank lines are skipped
+        words->words[words->count++] = line;
+    return true;
+}
+
+/**
+ * Compare two letters for qsort, by their bytes.
+ * @param x The first letter.
+ * @param y The second letter.
+ * @return Negative, zero or positive as x comes before, is or comes after y.
+ */
+int compare_letters(const void *x, const void *y)
+{
+    return strcmp(x, y);
+}
+
+/**
+ * Find the alphabet and the number of letters in each word of the word list files.
+ * @param files The answers file and the guesses file.
+ * @param names The names of the files.
+ * @param alphabet The array to store each letter in.
+ * @param alphabet_size Where to store the number of letters.
+ * @param letter_size Where to store the most bytes of any letter.
+ * @return The number of letters in each word, or NULL_INDEX if the words are unsupported, an error is printed if so.
+ */
+int read_alphabet(struct text_words files[2], char *names[2], char alphabet[MAX_ALPHABET_SIZE][MAX_LETTER_SIZE], int *alphabet_size, int *letter_size)
+{
+    int length = NULL_INDEX;
+    *alphabet_size = 0;
+    *letter_size = 1;
+    for (int file = 0; file < 2; file++)
+    {
+        for (int i = 0; i < files[file].count; i++)
+        {
+            char *word = files[file].words[i];
+            int letters = 0;
+            for (int size; (size = get_letter_size(word)) > 0; word += size, letters++)
+            {
+                char letter[MAX_LETTER_SIZE] = "";
+                memcpy(letter, word, size);
+                if (size == 1 && letter[0] >= 'A' && letter[0] <= 'Z') // words are case insensitive
+                    letter[0] += 'a' - 'A';
+
+                int found = 0;
+                while (found < *alphabet_size && strcmp(alphabet[found], letter) != 0)
+                    found++;
+                if (found == MAX_ALPHABET_SIZE)
+                {
+                    printf("** ERROR: the words use more than %d letters **\n", MAX_ALPHABET_SIZE);
+                    return NULL_INDEX;
+                }
+                if (found == *alphabet_size)
+                    strcpy(alphabet[(*alphabet_size)++], letter);
+                *letter_size = size > *letter_size ? size : *letter_size;
+            }
+
+            if (length == NULL_INDEX)
+                length = letters;
+            if (letters != length || length > MAX_WORD_LENGTH)
+            {
+                printf("** ERROR: '%s' in %s doesn't have the same number of letters as the other words (at most %d) **\n",
+                       files[file].words[i], names[file], MAX_WORD_LENGTH);
+                return NULL_INDEX;
+            }
+        }
+    }
+    qsort(alphabet, *alphabet_size, sizeof(alphabet[0]), compare_letters);
+    return length;
+}
+
+/**
+ * Load a word list from the answers and guesses files.
+ * The guesses are the answers followed by the words of the guesses file, and the alphabet is every letter they use.
+ * @param list The word list to load into.
+ * @param answers_file The file listing the answers, one per line.
+ * @param guesses_file The file listing the guesses that aren't answers, one per line.
+ * @return Boolean indicating whether the word list was loaded, an error is printed if not.
+ */
+bool load_text_word_list(struct word_list *list, char *answers_file, char *guesses_file)
+{
+    struct text_words files[2] = {};
+    char *names[2] = {answers_file, guesses_file};
+    bool loaded = true;
+    for (int i = 0; i < 2 && loaded; i++)
+    {
+        loaded = read_text_words(&files[i], names[i]);
+        if (!loaded)
+            printf("** ERROR: could not read %s **\n", names[i]);
+    }
+
+    char alphabet[MAX_ALPHABET_SIZE][MAX_LETTER_SIZE] = {};
+    int alphabet_size, letter_size;
+    int length = loaded ? read_alphabet(files, names, alphabet, &alphabet_size, &letter_size) : NULL_INDEX;
+    loaded = length != NULL_INDEX;
+    if (loaded && !init_word_list(list, files[0].count, files[0].count + files[1].count, length, alphabet_size, letter_size))
+    {
+        printf("** ERROR: the word lists are empty or too large **\n");
+        loaded = false;
+    }
+
+    if (loaded)
+    {
+        memcpy(list->alphabet, alphabet, sizeof(alphabet[0]) * alphabet_size);
+        index_alphabet(list);
+        for (int i = 0; i < list->guess_count; i++)
+        {
+            char *word = i < files[0].count ? files[0].words[i] : files[1].words[i - files[0].count];
+            for (int j = 0, size; j < list->length; j++, word += size)
+                get_letters(list, i)[j] = find_letter(list, word, &size);
+        }
+        index_words(list);
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        free(files[i].buffer);
+        free(files[i].words);
+    }
+    return loaded;
+}
+
+/**
+ * Get where the codes start in a packed dictionary file, after the header and the alphabet.
+ * @param alphabet_size The number of letters in the alphabet.
+ * @return The offset in bytes, a multiple of DICTIONARY_ALIGNMENT.
+ */
+size_t get_codes_offset(int alphabet_size)
+{
+    size_t end = sizeof(struct dictionary_header) + sizeof(char[MAX_LETTER_SIZE]) * alphabet_size;
+    return (end + DICTIONARY_ALIGNMENT - 1) / DICTIONARY_ALIGNMENT * DICTIONARY_ALIGNMENT;
+}
+
+/**
+ * Load a word list from a packed dictionary file, which is memory mapped while it is decoded.
+ * @param list The word list to load into.
+ * @param file_name The name of the file.
+ * @return Boolean indicating whether the word list was loaded.
+ */
+bool load_dictionary(struct word_list *list, char *file_name)
+{
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size >= (off_t)sizeof(struct dictionary_header))
+        map = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping stays valid after the file is closed
+    if (map == MAP_FAILED)
+        return false;
+
+    struct dictionary_header *header = map;
+    char (*alphabet)[MAX_LETTER_SIZE] = (void *)(header + 1);
+    bool loaded = memcmp(header->magic, DICTIONARY_MAGIC, FEEDBACK_MAGIC_LENGTH) == 0 && (header->code_size == 4 || header->code_size == 8) &&
+                  header->alphabet_size >= 1 && header->alphabet_size <= MAX_ALPHABET_SIZE && header->guess_count >= 0 &&
+                  get_codes_offset(header->alphabet_size) + (size_t)header->guess_count * header->code_size == (size_t)info.st_size;
+
+    int letter_size = 1;
+    for (int i = 0; loaded && i < header->alphabet_size; i++)
+    {
+        loaded = alphabet[i][MAX_LETTER_SIZE - 1] == '\0';
+        letter_size = (int)strlen(alphabet[i]) > letter_size ? (int)strlen(alphabet[i]) : letter_size;
+    }
+    loaded = loaded && init_word_list(list, header->answer_count, header->guess_count, header->length, header->alphabet_size, letter_size);
+    if (loaded && list->letter_bits == header->letter_bits)
+    {
+        memcpy(list->alphabet, alphabet, sizeof(alphabet[0]) * list->alphabet_size);
+        index_alphabet(list);
+        void *codes = (char *)map + get_codes_offset(list->alphabet_size);
+        for (int i = 0; i < list->guess_count && loaded; i++)
+        {
+            unsigned long long code = header->code_size == 4 ? ((unsigned int *)codes)[i] : ((unsigned long long *)codes)[i];
+            for (int j = list->length - 1; j >= 0; j--, code >>= list->letter_bits)
+                get_letters(list, i)[j] = code & ((1U << list->letter_bits) - 1);
+            for (int j = 0; j < list->length; j++)
+                loaded = loaded && get_letters(list, i)[j] < list->alphabet_size;
+        }
+        if (loaded)
+        {
+            index_words(list);
+            loaded = list->checksum == header->checksum;
+        }
+    }
+    else
+        loaded = false;
+
+    if (!loaded && list->arena.base != NULL)
+        free_word_list(list);
+    munmap(map, info.st_size);
+    return loaded;
+}
+
+/**
+ * Save a word list as a packed dictionary.
+ * @param list The word list.
+ * @param file_name The name of the file to save to.
+ * @return Boolean indicating whether the dictionary was saved.
+ */
+bool save_dictionary(struct word_list *list, char *file_name)
+{
+    FILE *f = fopen(file_name, "wb");
+    if (f == NULL)
+        return false;
+
+    struct dictionary_header header = {.answer_count = list->answer_count, .guess_count = list->guess_count, .length = list->length,
+                                       .alphabet_size = list->alphabet_size, .letter_bits = list->letter_bits,
+                                       .code_size = list->length * list->letter_bits <= 32 ? 4 : 8, .checksum = list->checksum};
+    memcpy(header.magic, DICTIONARY_MAGIC, FEEDBACK_MAGIC_LENGTH);
+    char padding[DICTIONARY_ALIGNMENT] = {};
+    size_t padding_size = get_codes_offset(list->alphabet_size) - sizeof(header) - sizeof(list->alphabet[0]) * list->alphabet_size;
+    bool saved = fwrite(&header, sizeof(header), 1, f) == 1 &&
+                 fwrite(list->alphabet, sizeof(list->alphabet[0]), list->alphabet_size, f) == (size_t)list->alphabet_size &&
+                 fwrite(padding, 1, padding_size, f) == padding_size;
+    for (int i = 0; i < list->guess_count && saved; i++)
+    {
+        unsigned int short_code = list->codes[i];
+        if (header.code_size == 4)
+            saved = fwrite(&short_code, sizeof(short_code), 1, f) == 1;
+        else
+            saved = fwrite(&list->codes[i], sizeof(list->codes[i]), 1, f) == 1;
+    }
+    return fclose(f) == 0 && saved;
+}
+
+/**
+ * Check whether a file was modified after another.
+ * @param file_name The file.
+ * @param other_name The other file, which may be missing.
+ * @return Boolean indicating whether the file exists and is at least as new as the other file.
+ */
+bool is_newer(char *file_name, char *other_name)
+{
+    struct stat file, other;
+    if (stat(file_name, &file) != 0)
+        return false;
+    return stat(other_name, &other) != 0 || file.st_mtime >= other.st_mtime;
+}
+
+/**
+ * Fill in the word files that weren't given on the command line.
+ * With nothing given the default word lists and dictionary are used, with only a dictionary just the dictionary is used,
+ * and with any word list the lists are used without a dictionary unless one was also given.
+ * @param answers_file The answers file given, or NULL.
+ * @param guesses_file The guesses file given, or NULL.
+ * @param dictionary_file The dictionary file given, or NULL.
+ */
+void choose_word_files(char **answers_file, char **guesses_file, char **dictionary_file)
+{
+    if (*answers_file == NULL && *guesses_file == NULL)
+    {
+        if (*dictionary_file == NULL)
+        {
+            *answers_file = ANSWERS_FILE;
+            *guesses_file = GUESSES_FILE;
+            *dictionary_file = DICTIONARY_FILE;
+        }
+        return;
+    }
+    if (*answers_file == NULL)
+        *answers_file = ANSWERS_FILE;
+    if (*guesses_file == NULL)
+        *guesses_file = GUESSES_FILE;
+}
+
+/**
+ * Load the answers and guesses.
+ * A packed dictionary is used when it is at least as new as both word lists, or when there are no word lists.
+ * @param list The word list to load into.
+ * @param answers_file The file listing the answers, or NULL to only use the dictionary.
+ * @param guesses_file The file listing the guesses that aren't answers, or NULL to only use the dictionary.
+ * @param dictionary_file The packed dictionary, or NULL to only use the word lists.
+ * @return Boolean indicating whether the words were loaded, an error is printed if not.
+ */
+bool load_word_list(struct word_list *list, char *answers_file, char *guesses_file, char *dictionary_file)
+{
+    bool has_lists = answers_file != NULL && guesses_file != NULL;
+    if (dictionary_file != NULL && (!has_lists || (is_newer(dictionary_file, answers_file) && is_newer(dictionary_file, guesses_file))) &&
+        load_dictionary(list, dictionary_file))
+        return true;
+    if (has_lists)
+        return load_text_word_list(list, answers_file, guesses_file); // no usable dictionary, so parse the word lists
+
+    printf("** ERROR: could not load %s **\n", dictionary_file);
+    return false;
+}
+
+#endif
@@ -0,0 +1,443 @@
+/**
+ * Feedback pattern engine for Wordle.
+ * Every (guess, answer) pair produces exactly one outcome, encoded as a ternary number with one digit per letter
+ * (0 - 242 for 5 letter words). These codes are computed once into a matrix so that scoring a guess becomes a single pass
+ * that buckets the answers by their code.
+ * Codes are stored in a byte up to 5 letters and in 2 bytes above that. Every kernel reading the matrix is written once
+ * and specialised for each size, so words of up to 5 letters pay nothing for longer words being supported.
+ */
+
+#ifndef FEEDBACK_C
+#define FEEDBACK_C
+
+#include "shared.c"
+#include "bitset.c"
+#include "profile.c"
+#include "scratch.c"
+
+#define FEEDBACK_FILE "feedback.bin"                        // feedback matrix cache file name
+#define FEEDBACK_MAGIC "WRDLFBM2"                           // identifies a feedback matrix cache file
+#define FEEDBACK_MAGIC_LENGTH 8                             // the number of characters in the magic
+#define ALL_GREEN(list) ((list)->outcome_count - 1)         // the outcome code of a correct guess
+#define STRATEGY_VERSION 1                                  // bumped whenever the solver would choose different guesses, invalidating saved guesses
+#define INLINE static inline __attribute__((always_inline)) // a kernel body, specialised at each call
+
+/**
+ * The header at the start of the feedback matrix cache file.
+ */
+struct feedback_header
+{
+    char magic[FEEDBACK_MAGIC_LENGTH]; // FEEDBACK_MAGIC
+    int guess_count;                   // the number of rows in the matrix
+    int answer_count;                  // the number of columns in the matrix
+    int outcome_size;                  // the bytes of each outcome code
+    int padding;
+    unsigned long long checksum;       // checksum of the words the matrix was built from
+};
+
+/**
+ * Get the outcome code Wordle gives for a guess against an answer, for words of a given length.
+ * @param guess The letters of the guess.
+ * @param answer The letters of the answer.
+ * @param length The number of letters in each word.
+ * @return The outcome code.
+ */
+INLINE int get_feedback_of(unsigned char *guess, unsigned char *answer, int length)
+{
+    int outcome[MAX_WORD_LENGTH];
+    int remaining[MAX_ALPHABET_SIZE]; // letters of the answer not already matched by a green, only the letters of the words are used
+    for (int i = 0; i < length; i++)
+    {
+        remaining[guess[i]] = 0;
+        remaining[answer[i]] = 0;
+    }
+
+    for (int i = 0; i < length; i++)
+    {
+        if (guess[i] == answer[i])
+            outcome[i] = GREEN;
+        else
+        {
+            outcome[i] = BLACK;
+            remaining[answer[i]]++;
+        }
+    }
+
+    int code = 0;
+    for (int i = 0; i < length; i++)
+    {
+        if (outcome[i] == BLACK && remaining[guess[i]] > 0) // letter is in the answer, but not here
+        {
+            outcome[i] = ORANGE;
+            remaining[guess[i]]--;
+        }
+        code = code * OUTCOMES_LENGTH + outcome[i]; // first letter is the most significant digit
+    }
+    return code;
+}
+
+/**
+ * Get the outcome code Wordle gives for a guess against an answer.
+ * Greens are assigned first, then oranges from left to right while unmatched letters of the answer remain.
+ * @param list The word list.
+ * @param guess The letters of the guess.
+ * @param answer The letters of the answer.
+ * @return The outcome code, a ternary number with the first letter as the most significant digit.
+ */
+int get_feedback(struct word_list *list, unsigned char *guess, unsigned char *answer)
+{
+    if (list->length == FAST_PATH_LENGTH) // the fast path, unrolled for the usual length
+        return get_feedback_of(guess, answer, FAST_PATH_LENGTH);
+    return get_feedback_of(guess, answer, list->length);
+}
+
+/**
+ * Get a checksum of the answers and guesses, used to detect a stale file built from other words.
+ * @param list The word list.
+ * @return The 64-bit FNV-1a hash of the number of answers and every guess.
+ */
+unsigned long long get_words_checksum(struct word_list *list)
+{
+    unsigned long long hash = (14695981039346656037ULL ^ list->answer_count) * 1099511628211ULL;
+    for (int i = 0; i < list->guess_count; i++)
+    {
+        char *word = get_word(list, i);
+        for (int j = 0; word[j] != '\0'; j++)
+        {
+            hash ^= (unsigned char)word[j];
+            hash *= 1099511628211ULL;
+        }
+        hash ^= '\n'; // separate the words, as letters may have different sizes
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * Get the size of the feedback matrix.
+ * @param list The word list.
+ * @return The size in bytes.
+ */
+size_t get_feedback_size(struct word_list *list)
+{
+    return (size_t)list->guess_count * list->answer_count * list->outcome_size;
+}
+
+/**
+ * Load the feedback matrix from the cache file, if it matches the current words.
+ * @param list The word list to load the matrix of.
+ * @return Boolean indicating whether the matrix was loaded.
+ */
+bool load_feedback_matrix(struct word_list *list)
+{
+    FILE *f = fopen(FEEDBACK_FILE, "rb");
+    if (f == NULL)
+        return false;
+
+    struct feedback_header header;
+    bool loaded = fread(&header, sizeof(header), 1, f) == 1 &&
+                  memcmp(header.magic, FEEDBACK_MAGIC, FEEDBACK_MAGIC_LENGTH) == 0 &&
+                  header.guess_count == list->guess_count && header.answer_count == list->answer_count &&
+                  header.outcome_size == list->outcome_size && header.checksum == list->checksum &&
+                  fread(list->feedback, get_feedback_size(list), 1, f) == 1;
+    fclose(f);
+    return loaded;
+}
+
+/**
+ * Save the feedback matrix to the cache file, failure to do so is not an error.
+ * @param list The word list to save the matrix of.
+ */
+void save_feedback_matrix(struct word_list *list)
+{
+    FILE *f = fopen(FEEDBACK_FILE, "wb");
+    if (f == NULL)
+        return;
+
+    struct feedback_header header = {.guess_count = list->guess_count, .answer_count = list->answer_count,
+                                     .outcome_size = list->outcome_size, .checksum = list->checksum};
+    memcpy(header.magic, FEEDBACK_MAGIC, FEEDBACK_MAGIC_LENGTH);
+    fwrite(&header, sizeof(header), 1, f);
+    fwrite(list->feedback, get_feedback_size(list), 1, f);
+    fclose(f);
+}
+
+/**
+ * Fill in the feedback matrix, the outcome code of every guess against every answer.
+ * The matrix is loaded from FEEDBACK_FILE when possible, otherwise it is built and cached there.
+ * @param list The word list, whose feedback matrix has been allocated.
+ */
+void get_feedback_matrix(struct word_list *list)
+{
+    if (load_feedback_matrix(list))
+        return;
+
+    for (int i = 0; i < list->guess_count; i++)
+    {
+        unsigned char *guess = get_letters(list, i);
+        for (int j = 0; j < list->answer_count; j++)
+        {
+            int code = get_feedback(list, guess, get_letters(list, j));
+            size_t cell = (size_t)i * list->answer_count + j;
+            if (list->outcome_size == 1)
+                ((unsigned char *)list->feedback)[cell] = code;
+            else
+                ((unsigned short *)list->feedback)[cell] = code;
+        }
+    }
+    save_feedback_matrix(list);
+}
+
+/**
+ * Get the feedback matrix row of a guess.
+ * @param list The word list.
+ * @param guess The index of the guess.
+ * @return The row, the outcome code of the guess against each answer.
+ */
+void *get_feedback_row(struct word_list *list, int guess)
+{
+    return (char *)list->feedback + (size_t)guess * list->answer_count * list->outcome_size;
+}
+
+/**
+ * Read an outcome code from a feedback matrix row.
+ * @param row The row.
+ * @param answer The index of the answer.
+ * @param outcome_size The bytes of each outcome code.
+ * @return The outcome code.
+ */
+INLINE int get_row_outcome(void *row, int answer, int outcome_size)
+{
+    return outcome_size == 1 ? ((unsigned char *)row)[answer] : ((unsigned short *)row)[answer];
+}
+
+/**
+ * Get the outcome code of a guess against an answer.
+ * @param list The word list.
+ * @param guess The index of the guess.
+ * @param answer The index of the answer.
+ * @return The outcome code.
+ */
+int get_outcome(struct word_list *list, int guess, int answer)
+{
+    return get_row_outcome(get_feedback_row(list, guess), answer, list->outcome_size);
+}
+
+/**
+ * Get the outcome code of an outcome.
+ * @param list The word list.
+ * @param outcome The outcome, one GREEN, ORANGE or BLACK per letter.
+ * @return The outcome code.
+ */
+int get_outcome_code(struct word_list *list, int outcome[MAX_WORD_LENGTH])
+{
+    int code = 0;
+    for (int i = 0; i < list->length; i++)
+        code = code * OUTCOMES_LENGTH + outcome[i];
+    return code;
+}
+
+/**
+ * Bucket the available answers by the outcome they give for a feedback matrix row, see score_guess.
+ */
+INLINE double score_row(struct word_list *list, void *row, int outcome_size, unsigned long long *answer_set, int *answers_left)
+{
+    int total = 0;     // number of valid outcomes
+    int possibles = 0; // number of possible answers
+
+    for (int i = 0; i < list->set_words; i++)
+    {
+        for (unsigned long long bits = answer_set[i]; bits != 0; bits &= bits - 1) // for each answer in this word of the set
+        {
+            if (answers_left[get_row_outcome(row, i * WORD_BITS + __builtin_ctzll(bits), outcome_size)]++ == 0) // first answer for this outcome makes it valid
+                total++;
+            possibles++;
+        }
+    }
+    profile_count(COUNT_OUTCOMES, possibles);
+    return (double)possibles / total;
+}
+
+/**
+ * Score a guess by bucketing the available answers by the outcome they give.
+ * @param list The word list.
+ * @param guess The index of the guess.
+ * @param answer_set The set of available answers.
+ * @return The average number of answers left over every outcome that has answers left.
+ */
+double score_guess(struct word_list *list, int guess, unsigned long long *answer_set)
+{
+    int *answers_left = get_scratch(list)->outcome_counts; // number of answers left for each outcome
+    memset(answers_left, 0, sizeof(int) * list->outcome_count);
+    if (list->outcome_size == 1)
+        return score_row(list, get_feedback_row(list, guess), 1, answer_set, answers_left);
+    return score_row(list, get_feedback_row(list, guess), 2, answer_set, answers_left);
+}
+
+/**
+ * Count the outcomes the available answers give for a feedback matrix row, see count_outcomes.
+ */
+INLINE int count_row_outcomes(struct word_list *list, void *row, int outcome_size, unsigned long long *answer_set, int answers_left, int needed,
+                              bool *has_answers)
+{
+    int outcomes = 0;
+    int unchecked = answers_left; // each unchecked answer could still add an outcome
+
+    for (int i = 0; i < list->set_words; i++)
+    {
+        for (unsigned long long bits = answer_set[i]; bits != 0; bits &= bits - 1) // for each answer in this word of the set
+        {
+            int outcome = get_row_outcome(row, i * WORD_BITS + __builtin_ctzll(bits), outcome_size);
+            outcomes += !has_answers[outcome];
+            has_answers[outcome] = true;
+            if (outcomes + --unchecked < needed)
+            {
+                profile_count(COUNT_OUTCOMES, answers_left - unchecked);
+                return 0;
+            }
+        }
+    }
+    profile_count(COUNT_OUTCOMES, answers_left);
+    return outcomes;
+}
+
+/**
+ * Count the outcomes a guess splits the available answers into, giving up once there can't be enough.
+ * @param list The word list.
+ * @param guess The index of the guess.
+ * @param answer_set The set of available answers.
+ * @param answers_left The number of available answers.
+ * @param needed The number of outcomes of interest, counting stops once it can't be reached.
+ * @return The number of outcomes that have answers left, or 0 if it is less than needed.
+ */
+int count_outcomes(struct word_list *list, int guess, unsigned long long *answer_set, int answers_left, int needed)
+{
+    bool *has_answers = get_scratch(list)->has_answers; // whether each outcome has answers left
+    memset(has_answers, 0, sizeof(bool) * list->outcome_count);
+    if (list->outcome_size == 1)
+        return count_row_outcomes(list, get_feedback_row(list, guess), 1, answer_set, answers_left, needed, has_answers);
+    return count_row_outcomes(list, get_feedback_row(list, guess), 2, answer_set, answers_left, needed, has_answers);
+}
+
+/**
+ * Find the most answers any outcome leaves for a feedback matrix row, see get_largest_outcome.
+ */
+INLINE int largest_row_outcome(struct word_list *list, void *row, int outcome_size, unsigned long long *answer_set, int limit, int *outcomes,
+                               int *answers_left)
+{
+    int largest = 0;
+    int checked = 0;
+    *outcomes = 0;
+
+    for (int i = 0; i < list->set_words; i++)
+    {
+        for (unsigned long long bits = answer_set[i]; bits != 0; bits &= bits - 1) // for each answer in this word of the set
+        {
+            int count = ++answers_left[get_row_outcome(row, i * WORD_BITS + __builtin_ctzll(bits), outcome_size)];
+            *outcomes += count == 1; // first answer for this outcome makes it valid
+            checked++;
+            if (count > largest && (largest = count) > limit)
+            {
+                profile_count(COUNT_OUTCOMES, checked);
+                return largest;
+            }
+        }
+    }
+    profile_count(COUNT_OUTCOMES, checked);
+    return largest;
+}
+
+/**
+ * Find the most answers a guess can leave, the largest of the buckets it splits the available answers into,
+ * giving up once that is more than a limit.
+ * @param list The word list.
+ * @param guess The index of the guess.
+ * @param answer_set The set of available answers.
+ * @param limit The most answers left of interest, bucketing stops once an outcome leaves more.
+ * @param outcomes Set to the number of outcomes that have answers left, when the most answers left is within limit.
+ * @return The most answers left by any outcome, or some number over limit if that is over limit.
+ */
+int get_largest_outcome(struct word_list *list, int guess, unsigned long long *answer_set, int limit, int *outcomes)
+{
+    int *answers_left = get_scratch(list)->outcome_counts; // number of answers left for each outcome
+    memset(answers_left, 0, sizeof(int) * list->outcome_count);
+    if (list->outcome_size == 1)
+        return largest_row_outcome(list, get_feedback_row(list, guess), 1, answer_set, limit, outcomes, answers_left);
+    return largest_row_outcome(list, get_feedback_row(list, guess), 2, answer_set, limit, outcomes, answers_left);
+}
+
+/**
+ * Add answers to or remove them from the outcome counts of a feedback matrix row, see update_outcome_counts.
+ */
+INLINE int update_row_counts(struct word_list *list, void *row, int outcome_size, unsigned long long *answer_set, unsigned short *counts, bool add)
+{
+    int change = 0;
+    int answers = 0;
+    for (int i = 0; i < list->set_words; i++)
+    {
+        for (unsigned long long bits = answer_set[i]; bits != 0; bits &= bits - 1) // for each answer in this word of the set
+        {
+            int outcome = get_row_outcome(row, i * WORD_BITS + __builtin_ctzll(bits), outcome_size);
+            if (add)
+                change += counts[outcome]++ == 0;
+            else
+                change -= --counts[outcome] == 0;
+            answers++;
+        }
+    }
+    profile_count(COUNT_OUTCOMES, answers);
+    return change;
+}
+
+/**
+ * Add answers to or remove them from the number of answers giving each outcome for a guess.
+ * @param list The word list.
+ * @param guess The index of the guess.
+ * @param answer_set The set of answers to add or remove, each removed answer must have been added.
+ * @param counts The number of answers giving each outcome, updated.
+ * @param add Boolean indicating whether to add the answers rather than remove them.
+ * @return The change in the number of outcomes that have answers.
+ */
+int update_outcome_counts(struct word_list *list, int guess, unsigned long long *answer_set, unsigned short *counts, bool add)
+{
+    if (list->outcome_size == 1)
+        return update_row_counts(list, get_feedback_row(list, guess), 1, answer_set, counts, add);
+    return update_row_counts(list, get_feedback_row(list, guess), 2, answer_set, counts, add);
+}
+
+/**
+ * Keep only the answers in a set that give an outcome for a feedback matrix row, see keep_outcome.
+ */
+INLINE int keep_row_outcome(struct word_list *list, void *row, int outcome_size, int outcome, unsigned long long *answer_set)
+{
+    int answers_left = 0;
+    for (int i = 0; i < list->set_words; i++)
+    {
+        unsigned long long kept = 0;
+        for (unsigned long long bits = answer_set[i]; bits != 0; bits &= bits - 1) // for each answer in this word of the set
+        {
+            int bit = __builtin_ctzll(bits);
+            kept |= (unsigned long long)(get_row_outcome(row, i * WORD_BITS + bit, outcome_size) == outcome) << bit;
+        }
+        answer_set[i] = kept;
+        answers_left += __builtin_popcountll(kept);
+    }
+    return answers_left;
+}
+
+/**
+ * Keep only the answers in a set that give an outcome for a guess, checking just the answers in the set.
+ * @param list The word list.
+ * @param guess The index of the guess.
+ * @param outcome The outcome code.
+ * @param answer_set The set to filter.
+ * @return The number of answers left in the set.
+ */
+int keep_outcome(struct word_list *list, int guess, int outcome, unsigned long long *answer_set)
+{
+    if (list->outcome_size == 1)
+        return keep_row_outcome(list, get_feedback_row(list, guess), 1, outcome, answer_set);
+    return keep_row_outcome(list, get_feedback_row(list, guess), 2, outcome, answer_set);
+}
+
+#endif
@@ -4,122 +4,171 @@
  * @date: 10-11-2022
  */
 
-#include "shared.c"
+#include "dictionary.c"
+#include "feedback.c"
+#include "pairs.c"
+#include "parallel.c"
 
 #define OUTPUT_FILE "first_guess.txt" // output file name
-#define OUTPUT_LENGTH 20              // the length of each output in output file "XXXXX - "
+#define DEFAULT_TOP_PAIRS 100         // the number of pairs of first guesses kept by --pairs
 
 /**
- * Find the minimum of a number array from index to end.
- * @param array The array to find the minimum of.
+ * Merge two sorted halves of an array, whilst shuffling another array with respect to the first.
+ * Elements of the left half come first on ties, which keeps the sort stable.
+ * @param array The array to merge, sorted in [start, middle) and [middle, end).
+ * @param another The second array to shuffle with respect to the first.
+ * @param start The start of the left half.
+ * @param middle The start of the right half.
+ * @param end The end of the right half.
+ * @param array_buffer Scratch space the size of array.
+ * @param another_buffer Scratch space the size of another.
+ */
+void merge(double *array, int *another, int start, int middle, int end, double *array_buffer, int *another_buffer)
+{
+    int i = start, j = middle, k = start;
+    while (i < middle || j < end)
+    {
+        int from = (j >= end || (i < middle && array[i] <= array[j])) ? i++ : j++;
+        array_buffer[k] = array[from];
+        another_buffer[k++] = another[from];
+    }
+    memcpy(&array[start], &array_buffer[start], sizeof(double) * (end - start));
+    memcpy(&another[start], &another_buffer[start], sizeof(int) * (end - start));
+}
+
+/**
+ * Perform a stable merge sort on an array, whilst shuffling another array with respect to the first.
+ * @param array The array to sort.
  * @param n The number of elements in the array.
- * @param index The index to start looking from.
- * @return The minimum of the array starting at index.
+ * @param another The second array to shuffle with respect to the first.
  */
-int min(double *array, int n, int index)
+void merge_sort(double *array, int n, int *another)
 {
-    int min = index;
-    for (int i = index + 1; i < n; i++)
+    double *array_buffer = malloc(sizeof(double) * n);
+    int *another_buffer = malloc(sizeof(int) * n);
+    for (int width = 1; width < n; width *= 2) // merge runs of width into runs of 2 * width
     {
-        if (array[i] < array[min])
+        for (int start = 0; start + width < n; start += 2 * width)
         {
-            min = i;
+            int end = start + 2 * width < n ? start + 2 * width : n;
+            merge(array, another, start, start + width, end, array_buffer, another_buffer);
         }
     }
-    return min;
+    free(array_buffer);
+    free(another_buffer);
 }
 
 /**
- * Swap two numeric elements in two arrays.
- * @param array The first array to swap elements in.
- * @param x The first index of the swap to perform.
- * @param y The second index of the swap to perform.
- * @param another The second array to swap elements in.
+ * The data shared by every worker ranking the guesses.
  */
-void swap(double *array, int x, int y, int *another)
+struct ranking
 {
-    double tmp = array[x];
-    array[x] = array[y];
-    array[y] = tmp;
-
-    int tmp2 = another[x];
-    another[x] = another[y];
-    another[y] = tmp2;
-}
+    struct word_list *list;         // the word list and its feedback matrix
+    unsigned long long *answer_set; // the set of available answers
+    double *guess_results;          // the average words left of each guess
+};
 
 /**
- * Perform selection sort on an array, whilst shuffling another array with respect to the first.
- * @param array The array to sort.
- * @param n The number of elements in the array.
- * @param another The second array to shuffle with respect to the first.
+ * Get the average words left for one guess.
+ * @param index The index of the guess.
+ * @param context The ranking to store the result in.
  */
-void selection_sort(double *array, int n, int *another)
+void rank_guess(int index, void *context)
 {
-    for (int i = 0; i < n; i++)
-    {
-        int min_index = min(array, n, i);
-        swap(array, min_index, i, another);
-    }
+    struct ranking *ranking = context;
+    ranking->guess_results[index] = score_guess(ranking->list, index, ranking->answer_set);
 }
 
 /**
  * Get and print to a file all valid guesses and their corresponding average words left (in sorted order) for the first guess of Wordle.
- * @param guesses The array of all valid guesses.
- * @param answers The array of all valid answers.
- * @param outcomes The array of possible outcomes.
+ * @param list The word list and its feedback matrix.
+ * @param threads The number of worker threads to score the guesses with.
  */
-void explore_possible_guesses(char guesses[GUESSES_LENGTH][WORD_SIZE], char answers[ANSWER_LENGTH][WORD_SIZE], int outcomes[TOTAL_OUTCOMES][WORD_SIZE - 1])
+void explore_possible_guesses(struct word_list *list, int threads)
 {
-    double guess_results[GUESSES_LENGTH];
-    for (int i = 0; i < GUESSES_LENGTH; i++) // for each guess
-    {
-        int total = TOTAL_OUTCOMES; // initialise total number of valid outcomes
-        int possibles = 0;          // initialise number of possible answers
-
-        for (int j = 0; j < TOTAL_OUTCOMES; j++) // for each outcome
-        {
-            int answers_left = 0;                   // initialise number of answers left for this outcome
-            for (int k = 0; k < ANSWER_LENGTH; k++) // for each answer check if it is possible with the current guess and outcome
-            {
-                if (is_possible(answers[k], guesses[i], outcomes[j]))
-                    answers_left++; // if so add to number of answers left for this outcome
-            }
-
-            if (answers_left == 0)     // if we have no answers left for this outcome
-                total--;               // valid outcomes decreases
-            possibles += answers_left; // add to total number of possible answers
-        }
-        guess_results[i] = (double)possibles / total; // get the average number of answers left for this guess
+    unsigned long long answer_set[list->set_words]; // every answer is available for the first guess
+    fill_set(list, answer_set);
 
-        printf("Checking %d/%d\r", i + 1, GUESSES_LENGTH); // print current state of processing
-        fflush(stdout);                                    // flush stdout for cleaner '\r' printing
-    }
+    double *guess_results = malloc(sizeof(double) * list->guess_count);
+    struct ranking ranking = {list, answer_set, guess_results};
+    parallel_for(list->guess_count, threads, rank_guess, &ranking, "Checking"); // get the average number of answers left for each guess
 
-    int guess_indexes[GUESSES_LENGTH]; // get all indexes so that we can sort them with the results
-    for (int i = 0; i < GUESSES_LENGTH; i++)
+    int *guess_indexes = malloc(sizeof(int) * list->guess_count); // get all indexes so that we can sort them with the results
+    for (int i = 0; i < list->guess_count; i++)
         guess_indexes[i] = i;
 
-    selection_sort(guess_results, GUESSES_LENGTH, guess_indexes); // sort the guess results
+    merge_sort(guess_results, list->guess_count, guess_indexes); // sort the guess results, ties stay in guess order
 
     FILE *f = fopen(OUTPUT_FILE, "w");
-    for (int i = 0; i < GUESSES_LENGTH; i++)
-    {
-        char output[OUTPUT_LENGTH] = "\0";
-        strcpy(output, guesses[guess_indexes[i]]);
-        strcat(output, " - ");
-        fprintf(f, "%s%5.2lf\n", output, guess_results[i]);
-    }
+    for (int i = 0; i < list->guess_count; i++)
+        fprintf(f, "%s - %5.2lf\n", get_word(list, guess_indexes[i]), guess_results[i]);
+    fclose(f);
+    free(guess_results);
+    free(guess_indexes);
 }
 
-int main()
+/**
+ * Print how to run the program.
+ * @param program The name of the program.
+ */
+void print_usage(char *program)
 {
-    char answers[ANSWER_LENGTH][WORD_SIZE];
-    char guesses[GUESSES_LENGTH][WORD_SIZE];
-    get_answers_guesses(answers, guesses); // get answers and guesses
+    printf("usage: %s [-t threads] [--profile] [--pairs [--top-k K] [--resume]] [--answer-list FILE] [--guess-list FILE] [--dictionary FILE]\n", program);
+    printf("  -t, --threads N     score guesses over N worker threads (default: number of processors)\n");
+    printf("  --profile           print how many outcomes were evaluated on exit\n");
+    printf("  --pairs             rank pairs of first guesses instead, writing the best to %s as the search goes\n", PAIRS_FILE);
+    printf("  --top-k K           the number of pairs kept (default: %d)\n", DEFAULT_TOP_PAIRS);
+    printf("  --resume            continue the pair search from %s, saved after every %d first guesses\n", PAIRS_CHECKPOINT_FILE, PAIR_BLOCK_ROWS);
+    printf("  --answer-list FILE  the answers, one per line (default: %s)\n", ANSWERS_FILE);
+    printf("  --guess-list FILE   the guesses that aren't answers, one per line (default: %s)\n", GUESSES_FILE);
+    printf("  --dictionary FILE   the packed dictionary, used instead of the lists when it is newer (default: %s)\n", DICTIONARY_FILE);
+}
 
-    int all_outcomes[TOTAL_OUTCOMES][WORD_SIZE - 1];
-    get_all_possible_outcomes(all_outcomes); // get all outcomes
+int main(int argc, char *argv[])
+{
+    int threads = get_thread_count(), top_k = DEFAULT_TOP_PAIRS;
+    bool pairs = false, resume = false;
+    char *answer_list = NULL, *guess_list = NULL, *dictionary = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        bool has_value = i + 1 < argc;
+        if ((strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--threads") == 0) && has_value && atoi(argv[i + 1]) > 0)
+            threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--profile") == 0)
+            profiling = true;
+        else if (strcmp(argv[i], "--pairs") == 0)
+            pairs = true;
+        else if (strcmp(argv[i], "--top-k") == 0 && has_value && atoi(argv[i + 1]) > 0)
+            top_k = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--resume") == 0)
+            resume = true;
+        else if (strcmp(argv[i], "--answer-list") == 0 && has_value)
+            answer_list = argv[++i];
+        else if (strcmp(argv[i], "--guess-list") == 0 && has_value)
+            guess_list = argv[++i];
+        else if (strcmp(argv[i], "--dictionary") == 0 && has_value)
+            dictionary = argv[++i];
+        else
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
 
-    explore_possible_guesses(guesses, answers, all_outcomes);
-    return 0;
+    choose_word_files(&answer_list, &guess_list, &dictionary);
+    struct word_list list;
+    if (!load_word_list(&list, answer_list, guess_list, dictionary)) // get answers and guesses
+        return 1;
+
+    get_feedback_matrix(&list); // get the outcome of every guess against every answer
+
+    int status = 0;
+    if (pairs)
+        status = !explore_possible_pairs(&list, top_k, threads, resume);
+    else
+        explore_possible_guesses(&list, threads);
+    if (profiling)
+        print_profile(stdout);
+    free_word_list(&list);
+    return status;
 }
\ No newline at end of file
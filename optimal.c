@@ -0,0 +1,479 @@
+/**
+ * Exact search for the strategy minimising the expected number of guesses, rather than the answers left after one guess.
+ * The cost of a set of answers is the fewest total guesses that solve every answer in it, so the expected number of
+ * guesses is the cost divided by the number of answers. It is searched depth first over (set of answers, guess):
+ * - each set's cost is memoised, along with the best guess, or a lower bound when the search was cut short
+ * - a set of n answers costs at least 2n - 1, as at most one answer is guessed first time, which gives an admissible
+ *   lower bound on every guess from the sizes of the outcomes it splits the answers into
+ * - guesses are tried in order of that bound, only the best top_k of them, and stop once the bound can't beat the best
+ * The openers are searched over a pool of worker threads, sharing the memo and the best cost found so far.
+ */
+
+#ifndef OPTIMAL_C
+#define OPTIMAL_C
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include "feedback.c"
+#include "parallel.c"
+
+#define OPTIMAL_INFINITY (1 << 29) // the cost of a set that can't be solved in the guesses left
+#define MEMO_LOCKS 64              // the number of locks striped over the memo's buckets
+
+/**
+ * A memoised set of answers.
+ */
+struct memo_entry
+{
+    unsigned long long key;          // hash_set of the answers
+    int next;                        // the next entry in the same hash bucket, or NULL_INDEX
+    int depth;                       // the most guesses each answer may take
+    int cost;                        // the cost of the set, or a lower bound on it if not exact
+    int guess;                       // the best guess, if exact
+    bool exact;                      // whether cost is the cost of the set
+    unsigned long long answer_set[]; // the answers
+};
+
+/**
+ * The memo of the cost of each set of answers searched, safe to share between threads.
+ * Entries are never evicted, once the memory budget is used up new sets are no longer memoised.
+ */
+struct optimal_memo
+{
+    struct word_list *list;
+    char *entries;                     // the entries, entry_size bytes each
+    size_t entry_size;                 // the size of an entry, including its set of answers
+    int capacity;                      // the most entries the memory budget allows
+    atomic_int count;                  // the number of entries claimed
+    int *buckets;                      // the first entry in each hash bucket, or NULL_INDEX
+    int bucket_mask;                   // the number of buckets - 1, the number of buckets is a power of 2
+    pthread_mutex_t locks[MEMO_LOCKS]; // bucket i is guarded by lock i % MEMO_LOCKS
+};
+
+/**
+ * A guess that could be tried for a set of answers, 8 bytes so a scratch guess table holds one per guess.
+ */
+struct candidate
+{
+    int guess; // the index of the guess
+    int bound; // a lower bound on the cost of the set when making this guess
+};
+
+/**
+ * The state of a search, shared by every worker.
+ */
+struct optimal_search
+{
+    struct word_list *list;
+    struct optimal_memo memo;
+    int top_k;          // the most guesses tried for each set of answers, 0 for every guess
+    atomic_long sets;   // the number of sets of answers searched, for reporting
+};
+
+/**
+ * Set up a search.
+ * @param search The search to set up.
+ * @param list The word list and its feedback matrix.
+ * @param top_k The most guesses tried for each set of answers, 0 to try every guess (which makes the search exact).
+ * @param budget The most memory the memo may use, in bytes.
+ */
+void init_optimal_search(struct optimal_search *search, struct word_list *list, int top_k, size_t budget)
+{
+    memset(search, 0, sizeof(*search));
+    search->list = list;
+    search->top_k = top_k;
+    atomic_init(&search->sets, 0);
+
+    struct optimal_memo *memo = &search->memo;
+    memo->list = list;
+    memo->entry_size = sizeof(struct memo_entry) + sizeof(unsigned long long) * list->set_words;
+    memo->entry_size = (memo->entry_size + sizeof(unsigned long long) - 1) / sizeof(unsigned long long) * sizeof(unsigned long long);
+    atomic_init(&memo->count, 0);
+    for (int i = 0; i < MEMO_LOCKS; i++)
+        pthread_mutex_init(&memo->locks[i], NULL);
+
+    size_t capacity = budget / (memo->entry_size + 2 * sizeof(int)); // each entry needs up to 2 buckets
+    int buckets = MEMO_LOCKS;
+    while ((size_t)buckets < capacity && buckets < (1 << 30))
+        buckets *= 2;
+    memo->capacity = capacity < (size_t)buckets ? (int)capacity : buckets;
+    memo->entries = memo->capacity > 0 ? malloc(memo->entry_size * memo->capacity) : NULL;
+    memo->buckets = malloc(sizeof(int) * buckets);
+    if (memo->entries == NULL || memo->buckets == NULL)
+        memo->capacity = 0;
+    memo->bucket_mask = buckets - 1;
+    for (int i = 0; memo->buckets != NULL && i < buckets; i++)
+        memo->buckets[i] = NULL_INDEX;
+}
+
+/**
+ * Release a search.
+ * @param search The search to release.
+ */
+void free_optimal_search(struct optimal_search *search)
+{
+    free(search->memo.entries);
+    free(search->memo.buckets);
+    for (int i = 0; i < MEMO_LOCKS; i++)
+        pthread_mutex_destroy(&search->memo.locks[i]);
+    memset(search, 0, sizeof(*search));
+}
+
+/**
+ * Get an entry of a memo.
+ * @param memo The memo.
+ * @param index The index of the entry.
+ * @return The entry.
+ */
+struct memo_entry *get_memo_entry(struct optimal_memo *memo, int index)
+{
+    return (struct memo_entry *)(memo->entries + index * memo->entry_size);
+}
+
+/**
+ * Find the memo entry of a set of answers, the caller must hold the lock of its bucket.
+ * @param memo The memo.
+ * @param key The hash of the set.
+ * @param answer_set The set of answers.
+ * @param depth The most guesses each answer may take.
+ * @return The index of the entry, or NULL_INDEX if the set isn't memoised.
+ */
+int find_memo_entry(struct optimal_memo *memo, unsigned long long key, unsigned long long *answer_set, int depth)
+{
+    for (int i = memo->buckets[key & memo->bucket_mask]; i != NULL_INDEX; i = get_memo_entry(memo, i)->next)
+    {
+        struct memo_entry *entry = get_memo_entry(memo, i);
+        if (entry->key == key && entry->depth == depth &&
+            memcmp(entry->answer_set, answer_set, sizeof(unsigned long long) * memo->list->set_words) == 0)
+            return i;
+    }
+    return NULL_INDEX;
+}
+
+/**
+ * Look up the memoised cost of a set of answers.
+ * @param memo The memo.
+ * @param answer_set The set of answers.
+ * @param depth The most guesses each answer may take.
+ * @param result Where to store a copy of the entry's cost, guess and exact fields.
+ * @return Boolean indicating whether the set is memoised.
+ */
+bool memo_lookup(struct optimal_memo *memo, unsigned long long *answer_set, int depth, struct memo_entry *result)
+{
+    if (memo->capacity == 0)
+        return false;
+
+    unsigned long long key = hash_set(memo->list, answer_set);
+    pthread_mutex_t *lock = &memo->locks[(key & memo->bucket_mask) % MEMO_LOCKS];
+    pthread_mutex_lock(lock);
+    int index = find_memo_entry(memo, key, answer_set, depth);
+    if (index != NULL_INDEX)
+    {
+        struct memo_entry *entry = get_memo_entry(memo, index);
+        result->cost = entry->cost;
+        result->guess = entry->guess;
+        result->exact = entry->exact;
+    }
+    pthread_mutex_unlock(lock);
+    return index != NULL_INDEX;
+}
+
+/**
+ * Memoise the cost of a set of answers, keeping the better of any cost already memoised.
+ * @param memo The memo.
+ * @param answer_set The set of answers.
+ * @param depth The most guesses each answer may take.
+ * @param cost The cost, or a lower bound on it.
+ * @param guess The best guess, if exact.
+ * @param exact Whether cost is the cost of the set.
+ */
+void memo_insert(struct optimal_memo *memo, unsigned long long *answer_set, int depth, int cost, int guess, bool exact)
+{
+    if (memo->capacity == 0)
+        return;
+
+    unsigned long long key = hash_set(memo->list, answer_set);
+    pthread_mutex_t *lock = &memo->locks[(key & memo->bucket_mask) % MEMO_LOCKS];
+    pthread_mutex_lock(lock);
+    int index = find_memo_entry(memo, key, answer_set, depth);
+    if (index == NULL_INDEX && atomic_load(&memo->count) < memo->capacity)
+    {
+        index = atomic_fetch_add(&memo->count, 1);
+        if (index < memo->capacity)
+        {
+            struct memo_entry *entry = get_memo_entry(memo, index);
+            entry->key = key;
+            entry->depth = depth;
+            entry->exact = false;
+            entry->cost = 0;
+            memcpy(entry->answer_set, answer_set, sizeof(unsigned long long) * memo->list->set_words);
+            entry->next = memo->buckets[key & memo->bucket_mask];
+            memo->buckets[key & memo->bucket_mask] = index;
+        }
+        else
+            index = NULL_INDEX;
+    }
+    if (index != NULL_INDEX)
+    {
+        struct memo_entry *entry = get_memo_entry(memo, index);
+        if (!entry->exact && (exact || cost > entry->cost)) // an exact cost is final, otherwise keep the tightest bound
+        {
+            entry->cost = cost;
+            entry->guess = guess;
+            entry->exact = exact;
+        }
+    }
+    pthread_mutex_unlock(lock);
+}
+
+/**
+ * Compare two candidates for qsort, by ascending bound and then by index.
+ * @param x The first candidate.
+ * @param y The second candidate.
+ * @return Negative, zero or positive as x is tried before, with or after y.
+ */
+int compare_candidates(const void *x, const void *y)
+{
+    const struct candidate *a = x, *b = y;
+    if (a->bound != b->bound)
+        return a->bound - b->bound;
+    return a->guess - b->guess;
+}
+
+/**
+ * Get the guesses to try for a set of answers, in the order to try them.
+ * A guess making an outcome of n_o answers costs at least n for itself plus 2n_o - 1 for each outcome that isn't the
+ * answer, and can't be made with one guess left after it unless every outcome has one answer.
+ * @param search The search.
+ * @param answer_set The set of answers.
+ * @param n The number of answers in the set.
+ * @param depth The most guesses each answer may take, at least 2.
+ * @param candidates The array to store the candidates in, with room for every guess.
+ * @return The number of candidates, at most top_k.
+ */
+int get_candidates(struct optimal_search *search, unsigned long long *answer_set, int n, int depth, struct candidate *candidates)
+{
+    struct word_list *list = search->list;
+    int count = 0;
+    for (int i = 0; i < list->guess_count; i++)
+    {
+        bool is_answer = i < list->answer_count && in_set(answer_set, i);
+        int outcomes = count_outcomes(list, i, answer_set, n, depth == 2 ? n : 0); // with 2 guesses left every outcome needs 1 answer
+        if (outcomes == 0 || (outcomes == 1 && !is_answer))                      // the guess can't finish in time or doesn't split the answers
+            continue;
+        int splits = outcomes - is_answer; // outcomes that aren't the answer
+        candidates[count++] = (struct candidate){.guess = i, .bound = n + 2 * (n - is_answer) - splits};
+    }
+    qsort(candidates, count, sizeof(struct candidate), compare_candidates);
+    return search->top_k > 0 && count > search->top_k ? search->top_k : count;
+}
+
+int get_set_cost(struct optimal_search *search, unsigned long long *answer_set, int n, int depth, int limit, int *best_guess);
+
+/**
+ * Get the cost of a set of answers when making a guess.
+ * The outcomes are searched largest first, each with a limit of what's left after the lower bound of the others.
+ * @param search The search.
+ * @param answer_set The set of answers.
+ * @param n The number of answers in the set.
+ * @param depth The most guesses each answer may take.
+ * @param candidate The guess and its lower bound.
+ * @param limit The search stops once the cost can't be below limit.
+ * @return The cost if it is below limit, otherwise a lower bound on it that is at least limit.
+ */
+int get_guess_cost(struct optimal_search *search, unsigned long long *answer_set, int n, int depth, struct candidate candidate, int limit)
+{
+    struct word_list *list = search->list;
+    struct scratch_level *tables = get_scratch_level(list, depth); // its outcomes are searched a depth down
+    int *counts = tables->outcome_counts; // the number of answers of each outcome
+    memset(counts, 0, sizeof(int) * list->outcome_count);
+    int outcomes[n]; // the outcome of each answer, in set order
+    int answers[n];
+    int k = 0;
+    for (int index = first_in_set(list, answer_set); index != NULL_INDEX; index = next_in_set(list, answer_set, index), k++)
+    {
+        answers[k] = index;
+        outcomes[k] = get_outcome(list, candidate.guess, index);
+        counts[outcomes[k]]++;
+    }
+
+    int *order = tables->outcome_order; // the outcomes that aren't the answer, largest first
+    int splits = 0;
+    for (int outcome = 0; outcome < ALL_GREEN(list); outcome++)
+    {
+        if (counts[outcome] == 0)
+            continue;
+        int i = splits++;
+        for (; i > 0 && counts[order[i - 1]] < counts[outcome]; i--) // insertion sort, ties stay in outcome order
+            order[i] = order[i - 1];
+        order[i] = outcome;
+    }
+
+    int total = candidate.bound; // the lower bound, with each outcome's bound replaced by its cost once searched
+    unsigned long long outcome_set[list->set_words];
+    for (int i = 0; i < splits && total < limit; i++)
+    {
+        int size = counts[order[i]];
+        memset(outcome_set, 0, sizeof(outcome_set));
+        for (int j = 0; j < n; j++)
+        {
+            if (outcomes[j] == order[i])
+                outcome_set[answers[j] / WORD_BITS] |= 1ULL << (answers[j] % WORD_BITS);
+        }
+        total -= 2 * size - 1;
+        total += get_set_cost(search, outcome_set, size, depth - 1, limit - total, NULL);
+    }
+    return total < OPTIMAL_INFINITY ? total : OPTIMAL_INFINITY;
+}
+
+/**
+ * Get the cost of a set of answers, the fewest total guesses that solve every answer in it.
+ * @param search The search.
+ * @param answer_set The set of answers.
+ * @param n The number of answers in the set.
+ * @param depth The most guesses each answer may take.
+ * @param limit The search stops once the cost can't be below limit.
+ * @param best_guess Where to store the best guess when the cost is below limit, or NULL.
+ * @return The cost if it is below limit, otherwise a lower bound on it that is at least limit (OPTIMAL_INFINITY if the
+ *         set can't be solved in time).
+ */
+int get_set_cost(struct optimal_search *search, unsigned long long *answer_set, int n, int depth, int limit, int *best_guess)
+{
+    int guess = first_in_set(search->list, answer_set);
+    if (best_guess != NULL)
+        *best_guess = guess;
+    if (n == 1) // guess it
+        return 1;
+    if (depth <= 1)
+        return OPTIMAL_INFINITY;
+    if (n == 2) // guess either, then the other if need be
+        return 3;
+
+    int lower_bound = 2 * n - 1;
+    struct memo_entry memoised;
+    if (lower_bound < limit && memo_lookup(&search->memo, answer_set, depth, &memoised))
+    {
+        if (memoised.exact && best_guess != NULL)
+            *best_guess = memoised.guess;
+        if (memoised.exact || memoised.cost >= limit)
+            return memoised.cost;
+        lower_bound = memoised.cost > lower_bound ? memoised.cost : lower_bound;
+    }
+    if (lower_bound >= limit)
+        return lower_bound;
+    atomic_fetch_add(&search->sets, 1);
+
+    struct candidate *candidates = get_scratch_level(search->list, depth)->guess_table; // not used by get_guess_cost
+    int count = get_candidates(search, answer_set, n, depth, candidates);
+    int best = limit; // only a cost below limit is of interest
+    int best_index = NULL_INDEX;
+    for (int i = 0; i < count && candidates[i].bound < best; i++) // candidates are in ascending order of bound
+    {
+        int cost = get_guess_cost(search, answer_set, n, depth, candidates[i], best);
+        if (cost < best)
+        {
+            best = cost;
+            best_index = i;
+            if (best <= lower_bound) // can't do better
+                break;
+        }
+    }
+
+    bool exact = best_index != NULL_INDEX;
+    if (exact)
+        guess = candidates[best_index].guess;
+    else if (count == 0 || candidates[0].bound >= OPTIMAL_INFINITY)
+        best = OPTIMAL_INFINITY; // no guess can solve the set in time
+    else
+        best = limit > lower_bound ? limit : lower_bound;
+
+    memo_insert(&search->memo, answer_set, depth, best, guess, exact);
+    if (exact && best_guess != NULL)
+        *best_guess = guess;
+    return best;
+}
+
+/**
+ * The search for the best opener, shared by every worker.
+ */
+struct opener_search
+{
+    struct optimal_search *search;
+    unsigned long long *answer_set; // every answer
+    int depth;                      // the most guesses each answer may take
+    struct candidate *candidates;   // the openers to try, in order
+    atomic_ullong best;             // (cost << 32) | rank of the best opener so far, the lower rank wins ties
+};
+
+/**
+ * Get the cost of one opener, unless it can't beat the best opener found so far.
+ * @param rank The rank of the opener in candidates.
+ * @param context The opener search.
+ */
+void search_opener(int rank, void *context)
+{
+    struct opener_search *openers = context;
+    unsigned long long best = atomic_load(&openers->best);
+    int limit = (int)(best >> 32) + (rank < (int)(best & 0xFFFFFFFF)); // an earlier opener only has to tie
+    if (openers->candidates[rank].bound >= limit)
+        return;
+
+    int n = count_set(openers->search->list, openers->answer_set);
+    int cost = get_guess_cost(openers->search, openers->answer_set, n, openers->depth, openers->candidates[rank], limit);
+    unsigned long long result = (unsigned long long)cost << 32 | rank;
+    while (result < best && !atomic_compare_exchange_weak(&openers->best, &best, result)) // on failure best is reloaded
+        ;
+}
+
+/**
+ * Find the opener with the lowest cost over every answer.
+ * @param search The search.
+ * @param depth The most guesses each answer may take.
+ * @param opener The only opener to search, or NULL_INDEX to search the top_k openers.
+ * @param threads The number of worker threads.
+ * @param cost Where to store the cost of the best opener, OPTIMAL_INFINITY if no opener can solve every answer in time.
+ * @return The index of the best opener, or NULL_INDEX if there is none.
+ */
+int find_optimal_opener(struct optimal_search *search, int depth, int opener, int threads, int *cost)
+{
+    struct word_list *list = search->list;
+    unsigned long long answer_set[list->set_words];
+    fill_set(list, answer_set);
+
+    struct candidate *candidates = malloc(sizeof(struct candidate) * list->guess_count);
+    int count = get_candidates(search, answer_set, list->answer_count, depth, candidates);
+    if (opener != NULL_INDEX) // keep only the opener given, it's tried even if it wouldn't be in the top_k
+    {
+        count = 0;
+        int outcomes = count_outcomes(list, opener, answer_set, list->answer_count, 0);
+        int splits = outcomes - (opener < list->answer_count);
+        candidates[count++] = (struct candidate){.guess = opener, .bound = 3 * list->answer_count - 2 * (opener < list->answer_count) - splits};
+    }
+
+    struct opener_search openers = {.search = search, .answer_set = answer_set, .depth = depth, .candidates = candidates};
+    atomic_init(&openers.best, (unsigned long long)OPTIMAL_INFINITY << 32 | 0xFFFFFFFF);
+    parallel_for(count, threads, search_opener, &openers, "Checking");
+
+    unsigned long long best = atomic_load(&openers.best);
+    *cost = (int)(best >> 32);
+    int result = *cost < OPTIMAL_INFINITY ? candidates[best & 0xFFFFFFFF].guess : NULL_INDEX;
+    free(candidates);
+    return result;
+}
+
+/**
+ * Get the best guess for a set of answers, after the search has found the cost of the set.
+ * @param search The search.
+ * @param answer_set The set of answers.
+ * @param depth The most guesses each answer may take.
+ * @return The index of the best guess, or NULL_INDEX if the set can't be solved in time.
+ */
+int get_optimal_guess(struct optimal_search *search, unsigned long long *answer_set, int depth)
+{
+    int guess;
+    int cost = get_set_cost(search, answer_set, count_set(search->list, answer_set), depth, OPTIMAL_INFINITY, &guess);
+    return cost < OPTIMAL_INFINITY ? guess : NULL_INDEX;
+}
+
+#endif
@@ -0,0 +1,31 @@
+/**
+ * Convert an answers list and a guesses list into a packed dictionary.
+ * usage: pack_words [ANSWERS GUESSES [OUTPUT]], by default answers.txt and guesses.txt into words.bin.
+ */
+
+#include "dictionary.c"
+
+int main(int argc, char *argv[])
+{
+    if (argc != 1 && argc != 3 && argc != 4)
+    {
+        printf("usage: %s [ANSWERS GUESSES [OUTPUT]] (default: %s %s %s)\n", argv[0], ANSWERS_FILE, GUESSES_FILE, DICTIONARY_FILE);
+        return 1;
+    }
+    char *answers_file = argc > 1 ? argv[1] : ANSWERS_FILE;
+    char *guesses_file = argc > 1 ? argv[2] : GUESSES_FILE;
+    char *output_file = argc > 3 ? argv[3] : DICTIONARY_FILE;
+
+    struct word_list list;
+    if (!load_text_word_list(&list, answers_file, guesses_file)) // always convert from the word lists, never from an old dictionary
+        return 1;
+
+    bool saved = save_dictionary(&list, output_file);
+    if (saved)
+        printf("** saved %d answers and %d guesses of %d letters (%d letter alphabet) to %s **\n", list.answer_count, list.guess_count,
+               list.length, list.alphabet_size, output_file);
+    else
+        printf("** ERROR: could not save %s **\n", output_file);
+    free_word_list(&list);
+    return !saved;
+}
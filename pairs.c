@@ -0,0 +1,410 @@
+/**
+ * Rank pairs of first guesses by the average number of answers left after both, the pair scored like a single guess
+ * over the outcomes of the two guesses together.
+ * Guesses are taken in order of their own number of outcomes, and each is paired with every guess after it:
+ * - a pair can't have more outcomes than the first guess's outcomes each split by at most the second guess's outcome
+ *   count, so once that can't beat the top_k pairs so far, neither can any later guess with the first
+ * - counting a pair's outcomes stops as soon as the rest of that bound can't beat the top_k either
+ * The first guesses are checked in blocks over a pool of worker threads, and after each block the top_k so far are
+ * written out and checkpointed, so a run that is stopped can be resumed from the last block.
+ */
+
+#ifndef PAIRS_C
+#define PAIRS_C
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include "feedback.c"
+#include "parallel.c"
+
+#define PAIRS_FILE "first_pairs.txt"             // the top pairs, rewritten after every block
+#define PAIRS_CHECKPOINT_FILE "first_pairs.ckpt" // the search state, rewritten after every block
+#define PAIRS_MAGIC "WRDLPRS1"                   // identifies a pair search checkpoint file
+#define PAIR_BLOCK_ROWS 64                       // the number of first guesses checked between checkpoints
+
+/**
+ * A pair of first guesses.
+ */
+struct pair_result
+{
+    int first;    // the index of the first guess, the lower index
+    int second;   // the index of the second guess
+    int outcomes; // the number of outcomes of both guesses together that have answers
+};
+
+/**
+ * The header at the start of a pair search checkpoint file, followed by its pairs.
+ */
+struct pairs_header
+{
+    char magic[FEEDBACK_MAGIC_LENGTH]; // PAIRS_MAGIC
+    int top_k;                         // the number of pairs kept
+    int rows_done;                     // the number of first guesses fully checked, in search order
+    int count;                         // the number of pairs that follow
+    unsigned long long checksum;       // checksum of the word lists searched
+};
+
+/**
+ * The state of a pair search, shared by every worker.
+ */
+struct pair_search
+{
+    struct word_list *list;
+    unsigned long long *answer_set; // every answer
+    int top_k;                      // the number of pairs kept
+    int *order;                     // the guesses in search order, most outcomes first
+    int *outcome_counts;            // the number of outcomes of each guess
+    unsigned short *bucket_sizes;   // the answers of each outcome of each guess, largest first, outcome_count per guess
+    int rows_done;                  // the number of first guesses fully checked
+    struct pair_result *best;       // a heap of the top_k pairs so far, the worst at the root
+    int count;                      // the number of pairs in the heap
+    atomic_int threshold;           // the outcomes of the worst pair kept once there are top_k, 0 before
+    pthread_mutex_t lock;           // guards best and count
+};
+
+/**
+ * Get whether one pair ranks worse than another, by fewer outcomes and then by later guesses.
+ * @param a The first pair.
+ * @param b The second pair.
+ * @return Boolean indicating whether a ranks worse than b.
+ */
+bool is_worse_pair(struct pair_result *a, struct pair_result *b)
+{
+    if (a->outcomes != b->outcomes)
+        return a->outcomes < b->outcomes;
+    return a->first != b->first ? a->first > b->first : a->second > b->second;
+}
+
+/**
+ * Compare two pairs for qsort, best first.
+ * @param x The first pair.
+ * @param y The second pair.
+ * @return Negative, zero or positive as x ranks before, with or after y.
+ */
+int compare_pairs(const void *x, const void *y)
+{
+    struct pair_result *a = (struct pair_result *)x, *b = (struct pair_result *)y;
+    return is_worse_pair(a, b) ? 1 : is_worse_pair(b, a) ? -1 : 0;
+}
+
+/**
+ * Restore the heap order of the top pairs below a position.
+ * @param search The pair search.
+ * @param i The position.
+ */
+void sift_down_pair(struct pair_search *search, int i)
+{
+    while (true)
+    {
+        int worst = i;
+        for (int child = 2 * i + 1; child <= 2 * i + 2 && child < search->count; child++)
+        {
+            if (is_worse_pair(&search->best[child], &search->best[worst]))
+                worst = child;
+        }
+        if (worst == i)
+            return;
+        struct pair_result swap = search->best[i];
+        search->best[i] = search->best[worst];
+        search->best[worst] = swap;
+        i = worst;
+    }
+}
+
+/**
+ * Offer a pair to the top pairs, keeping it if it ranks among the top_k.
+ * @param search The pair search.
+ * @param pair The pair.
+ */
+void offer_pair(struct pair_search *search, struct pair_result pair)
+{
+    pthread_mutex_lock(&search->lock);
+    if (search->count < search->top_k)
+    {
+        int i = search->count++;
+        for (; i > 0 && is_worse_pair(&pair, &search->best[(i - 1) / 2]); i = (i - 1) / 2) // sift up
+            search->best[i] = search->best[(i - 1) / 2];
+        search->best[i] = pair;
+    }
+    else if (is_worse_pair(&search->best[0], &pair))
+    {
+        search->best[0] = pair;
+        sift_down_pair(search, 0);
+    }
+    if (search->count == search->top_k)
+        atomic_store(&search->threshold, search->best[0].outcomes);
+    pthread_mutex_unlock(&search->lock);
+}
+
+/**
+ * Get the most outcomes a guess can have together with a guess of some number of outcomes.
+ * @param search The pair search.
+ * @param guess The index of the guess.
+ * @param outcomes The number of outcomes of the other guess.
+ * @return The sum over the guess's outcomes of the lesser of its answers and outcomes.
+ */
+int get_pair_bound(struct pair_search *search, int guess, int outcomes)
+{
+    unsigned short *sizes = &search->bucket_sizes[(size_t)guess * search->list->outcome_count];
+    int bound = 0;
+    for (int i = 0; i < search->outcome_counts[guess]; i++)
+        bound += sizes[i] < outcomes ? sizes[i] : outcomes;
+    return bound;
+}
+
+/**
+ * Check every pair of one first guess with the guesses after it in search order.
+ * @param index The index of the first guess in the block.
+ * @param context The pair search.
+ */
+void search_pair_row(int index, void *context)
+{
+    struct pair_search *search = context;
+    struct word_list *list = search->list;
+    int rank = search->rows_done + index;
+    int first = search->order[rank];
+    int first_outcomes = search->outcome_counts[first];
+
+    struct scratch_level *tables = get_scratch_level(list, 0);
+    int *counts = tables->outcome_counts; // group the answers by their outcome for the first guess, largest outcome first
+    memset(counts, 0, sizeof(int) * list->outcome_count);
+    int n = 0;
+    for (int answer = first_in_set(list, search->answer_set); answer != NULL_INDEX; answer = next_in_set(list, search->answer_set, answer), n++)
+        counts[get_outcome(list, first, answer)]++;
+    int *buckets = tables->outcome_order; // the outcomes that have answers, largest first
+    int bucket_count = 0;
+    for (int outcome = 0; outcome < list->outcome_count; outcome++)
+    {
+        if (counts[outcome] == 0)
+            continue;
+        int i = bucket_count++;
+        for (; i > 0 && counts[buckets[i - 1]] < counts[outcome]; i--)
+            buckets[i] = buckets[i - 1];
+        buckets[i] = outcome;
+    }
+    int *starts = tables->outcome_starts; // where each outcome's answers start in answers, by outcome
+    int answers[n];
+    for (int i = 0, start = 0; i < bucket_count; i++)
+    {
+        starts[buckets[i]] = start;
+        start += counts[buckets[i]];
+    }
+    for (int answer = first_in_set(list, search->answer_set); answer != NULL_INDEX; answer = next_in_set(list, search->answer_set, answer))
+        answers[starts[get_outcome(list, first, answer)]++] = answer;
+
+    int outcome_size = list->outcome_size;
+    unsigned int *seen = tables->outcome_stamps; // the last bucket each outcome of the second guess was seen in
+    memset(seen, 0, sizeof(unsigned int) * list->outcome_count);
+    unsigned int stamp = 0;
+    for (int other = rank + 1; other < list->guess_count; other++)
+    {
+        int second = search->order[other];
+        int second_outcomes = search->outcome_counts[second];
+        int threshold = atomic_load(&search->threshold);
+        int bound = get_pair_bound(search, first, second_outcomes);
+        if (bound < threshold) // later guesses have no more outcomes, so can't do better
+            break;
+        int other_bound = get_pair_bound(search, second, first_outcomes);
+        if (other_bound < threshold)
+            continue;
+
+        void *row = get_feedback_row(list, second); // read through the row, as the stores to seen could alias the word list
+        int outcomes = 0;
+        for (int i = 0, start = 0; i < bucket_count && outcomes + bound >= threshold; i++) // bound is what the unchecked buckets could add
+        {
+            int size = counts[buckets[i]];
+            bound -= size < second_outcomes ? size : second_outcomes;
+            stamp++;
+            for (int j = start; j < start + size; j++)
+            {
+                int outcome = get_row_outcome(row, answers[j], outcome_size);
+                outcomes += seen[outcome] != stamp;
+                seen[outcome] = stamp;
+            }
+            start += size;
+        }
+        if (outcomes >= threshold)
+            offer_pair(search, (struct pair_result){first < second ? first : second, first < second ? second : first, outcomes});
+    }
+}
+
+/**
+ * Save the state of a pair search to PAIRS_CHECKPOINT_FILE, replacing it only once the new one is written.
+ * @param search The pair search.
+ * @return Boolean indicating whether the checkpoint was saved.
+ */
+bool save_pairs_checkpoint(struct pair_search *search)
+{
+    char temporary[] = PAIRS_CHECKPOINT_FILE ".tmp";
+    FILE *f = fopen(temporary, "wb");
+    if (f == NULL)
+        return false;
+
+    struct pairs_header header = {.top_k = search->top_k, .rows_done = search->rows_done, .count = search->count, .checksum = search->list->checksum};
+    memcpy(header.magic, PAIRS_MAGIC, FEEDBACK_MAGIC_LENGTH);
+    bool saved = fwrite(&header, sizeof(header), 1, f) == 1 &&
+                 fwrite(search->best, sizeof(struct pair_result), search->count, f) == (size_t)search->count;
+    saved = fclose(f) == 0 && saved;
+    return saved && rename(temporary, PAIRS_CHECKPOINT_FILE) == 0;
+}
+
+/**
+ * Resume a pair search from PAIRS_CHECKPOINT_FILE, if it was saved from the same word lists and top_k.
+ * @param search The pair search, set up by init_pair_search.
+ * @return Boolean indicating whether the checkpoint was loaded.
+ */
+bool load_pairs_checkpoint(struct pair_search *search)
+{
+    FILE *f = fopen(PAIRS_CHECKPOINT_FILE, "rb");
+    if (f == NULL)
+        return false;
+
+    struct pairs_header header;
+    bool loaded = fread(&header, sizeof(header), 1, f) == 1 && memcmp(header.magic, PAIRS_MAGIC, FEEDBACK_MAGIC_LENGTH) == 0 &&
+                  header.checksum == search->list->checksum && header.top_k == search->top_k && header.count >= 0 &&
+                  header.count <= search->top_k && header.rows_done >= 0 && header.rows_done <= search->list->guess_count &&
+                  fread(search->best, sizeof(struct pair_result), header.count, f) == (size_t)header.count;
+    fclose(f);
+    if (!loaded)
+        return false;
+
+    search->count = header.count;
+    search->rows_done = header.rows_done;
+    for (int i = search->count / 2 - 1; i >= 0; i--) // the pairs were saved as a heap, but rebuild it in case
+        sift_down_pair(search, i);
+    atomic_store(&search->threshold, search->count == search->top_k && search->count > 0 ? search->best[0].outcomes : 0);
+    return true;
+}
+
+/**
+ * Write the top pairs so far to PAIRS_FILE, best first, in the format of OUTPUT_FILE.
+ * @param search The pair search.
+ * @return Boolean indicating whether the file was written.
+ */
+bool save_pairs(struct pair_search *search)
+{
+    FILE *f = fopen(PAIRS_FILE, "w");
+    if (f == NULL)
+        return false;
+
+    struct pair_result *sorted = malloc(sizeof(struct pair_result) * (search->count > 0 ? search->count : 1));
+    memcpy(sorted, search->best, sizeof(struct pair_result) * search->count);
+    qsort(sorted, search->count, sizeof(struct pair_result), compare_pairs);
+    for (int i = 0; i < search->count; i++)
+        fprintf(f, "%s %s - %5.3lf\n", get_word(search->list, sorted[i].first), get_word(search->list, sorted[i].second),
+                (double)search->list->answer_count / sorted[i].outcomes);
+    free(sorted);
+    return fclose(f) == 0;
+}
+
+int *compared_outcome_counts; // the outcome counts compare_by_outcomes sorts by, qsort takes no context
+
+/**
+ * Compare two guesses for qsort by their number of outcomes, most first and then by index.
+ * @param x The index of the first guess.
+ * @param y The index of the second guess.
+ * @return Negative, zero or positive as x is searched before, with or after y.
+ */
+int compare_by_outcomes(const void *x, const void *y)
+{
+    int a = *(const int *)x, b = *(const int *)y;
+    if (compared_outcome_counts[a] != compared_outcome_counts[b])
+        return compared_outcome_counts[b] - compared_outcome_counts[a];
+    return a - b;
+}
+
+/**
+ * Set up a pair search, counting the answers of each outcome of every guess.
+ * @param search The pair search to set up.
+ * @param list The word list and its feedback matrix.
+ * @param answer_set The set of every answer.
+ * @param top_k The number of pairs kept.
+ */
+void init_pair_search(struct pair_search *search, struct word_list *list, unsigned long long *answer_set, int top_k)
+{
+    memset(search, 0, sizeof(*search));
+    search->list = list;
+    search->answer_set = answer_set;
+    search->top_k = top_k;
+    search->order = malloc(sizeof(int) * list->guess_count);
+    search->outcome_counts = malloc(sizeof(int) * list->guess_count);
+    search->bucket_sizes = calloc((size_t)list->guess_count * list->outcome_count, sizeof(unsigned short));
+    search->best = malloc(sizeof(struct pair_result) * top_k);
+    atomic_init(&search->threshold, 0);
+    pthread_mutex_init(&search->lock, NULL);
+
+    for (int guess = 0; guess < list->guess_count; guess++)
+    {
+        unsigned short *sizes = &search->bucket_sizes[(size_t)guess * list->outcome_count];
+        for (int answer = first_in_set(list, answer_set); answer != NULL_INDEX; answer = next_in_set(list, answer_set, answer))
+            sizes[get_outcome(list, guess, answer)]++;
+        int count = 0; // move the outcomes with answers to the front, largest first
+        for (int outcome = 0; outcome < list->outcome_count; outcome++)
+        {
+            unsigned short size = sizes[outcome];
+            sizes[outcome] = 0;
+            if (size == 0)
+                continue;
+            int i = count++;
+            for (; i > 0 && sizes[i - 1] < size; i--)
+                sizes[i] = sizes[i - 1];
+            sizes[i] = size;
+        }
+        search->outcome_counts[guess] = count;
+        search->order[guess] = guess;
+    }
+    compared_outcome_counts = search->outcome_counts;
+    qsort(search->order, list->guess_count, sizeof(int), compare_by_outcomes);
+}
+
+/**
+ * Release a pair search.
+ * @param search The pair search to release.
+ */
+void free_pair_search(struct pair_search *search)
+{
+    free(search->order);
+    free(search->outcome_counts);
+    free(search->bucket_sizes);
+    free(search->best);
+    pthread_mutex_destroy(&search->lock);
+}
+
+/**
+ * Rank every pair of first guesses, writing the top_k to PAIRS_FILE and checkpointing after each block of first guesses.
+ * @param list The word list and its feedback matrix.
+ * @param top_k The number of pairs kept.
+ * @param threads The number of worker threads.
+ * @param resume Whether to continue from PAIRS_CHECKPOINT_FILE, when it matches the word lists and top_k.
+ * @return Boolean indicating whether the search finished and its results were written.
+ */
+bool explore_possible_pairs(struct word_list *list, int top_k, int threads, bool resume)
+{
+    unsigned long long answer_set[list->set_words]; // every answer is available for the first guesses
+    fill_set(list, answer_set);
+    struct pair_search search;
+    init_pair_search(&search, list, answer_set, top_k);
+    if (resume && load_pairs_checkpoint(&search))
+        printf("** resuming from %s after %d of %d first guesses **\n", PAIRS_CHECKPOINT_FILE, search.rows_done, list->guess_count);
+    else if (resume)
+        printf("** no checkpoint for these words and top %d in %s, starting over **\n", top_k, PAIRS_CHECKPOINT_FILE);
+
+    bool saved = true;
+    while (search.rows_done < list->guess_count && saved)
+    {
+        int rows = list->guess_count - search.rows_done < PAIR_BLOCK_ROWS ? list->guess_count - search.rows_done : PAIR_BLOCK_ROWS;
+        parallel_for(rows, threads, search_pair_row, &search, NULL);
+        search.rows_done += rows;
+
+        saved = save_pairs(&search) && save_pairs_checkpoint(&search);
+        printf("Checking %d/%d\r", search.rows_done, list->guess_count); // print current state of processing
+        fflush(stdout);
+    }
+    if (!saved)
+        printf("** ERROR: could not save %s or %s **\n", PAIRS_FILE, PAIRS_CHECKPOINT_FILE);
+    free_pair_search(&search);
+    return saved;
+}
+
+#endif
@@ -0,0 +1,160 @@
+/**
+ * Parallel loops over a pool of worker threads.
+ * Workers claim chunks of the loop from a shared counter, with chunks shrinking as the loop runs out
+ * so that a few slow indexes at the end don't leave the other threads idle.
+ */
+
+#ifndef PARALLEL_C
+#define PARALLEL_C
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "profile.c"
+#include "scratch.c"
+
+#define CHUNKS_PER_THREAD 8       // how many chunks each thread should get of the remaining work
+
+/**
+ * The state of a parallel loop shared by all of its workers.
+ */
+struct parallel_job
+{
+    int length;                            // the number of indexes in the loop
+    int threads;                           // the number of worker threads
+    void (*work)(int index, void *context); // the body of the loop
+    void *context;                         // passed to every call of work
+    atomic_int next;                       // the first index not yet claimed by a worker
+    atomic_int done;                       // the number of indexes completed
+    int running;                           // the number of workers still running (guarded by lock)
+    pthread_mutex_t lock;
+    pthread_cond_t finished;               // signalled when the last worker stops
+};
+
+/**
+ * Get the default number of worker threads.
+ * @return The number of online processors, or 1 if it can't be determined.
+ */
+int get_thread_count()
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+/**
+ * Claim the next chunk of a parallel loop.
+ * @param job The parallel loop.
+ * @param start Where to store the first index of the chunk.
+ * @return The number of indexes in the chunk, 0 when the loop has been fully claimed.
+ */
+int claim_chunk(struct parallel_job *job, int *start)
+{
+    int next = atomic_load(&job->next);
+    while (next < job->length)
+    {
+        int size = (job->length - next) / (job->threads * CHUNKS_PER_THREAD); // guided chunk size
+        if (size < 1)
+            size = 1;
+
+        if (atomic_compare_exchange_weak(&job->next, &next, next + size)) // on failure next is reloaded
+        {
+            *start = next;
+            return size;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Run chunks of a parallel loop until there are none left.
+ * @param argument The parallel loop.
+ * @return NULL.
+ */
+void *parallel_worker(void *argument)
+{
+    struct parallel_job *job = argument;
+    int start, size;
+    while ((size = claim_chunk(job, &start)) > 0)
+    {
+        for (int i = start; i < start + size; i++)
+            job->work(i, job->context);
+        atomic_fetch_add(&job->done, size);
+    }
+    merge_thread_profile();
+    free_thread_scratch();
+
+    pthread_mutex_lock(&job->lock);
+    if (--job->running == 0)
+        pthread_cond_signal(&job->finished);
+    pthread_mutex_unlock(&job->lock);
+    return NULL;
+}
+
+/**
+ * Run work(i, context) for every i in [0, length) over a pool of worker threads.
+ * The calling thread reports progress as "<label> done/length" at most every PROGRESS_INTERVAL_MS.
+ * If some workers can't be started the others run the whole loop, and if none can the calling thread runs it.
+ * @param length The number of indexes in the loop.
+ * @param threads The number of worker threads, at least 1.
+ * @param work The body of the loop, which must be safe to run concurrently for different indexes.
+ * @param context Passed to every call of work.
+ * @param label The progress label, or NULL to not report progress.
+ */
+void parallel_for(int length, int threads, void (*work)(int index, void *context), void *context, const char *label)
+{
+    if (threads < 1)
+        threads = 1;
+    if (threads > length)
+        threads = length > 0 ? length : 1;
+
+    struct parallel_job job = {.length = length, .threads = threads, .work = work, .context = context, .running = threads};
+    atomic_init(&job.next, 0);
+    atomic_init(&job.done, 0);
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.finished, NULL);
+
+    pthread_t *workers = malloc(sizeof(pthread_t) * threads);
+    int started = 0;
+    while (started < threads && pthread_create(&workers[started], NULL, parallel_worker, &job) == 0)
+        started++;
+
+    pthread_mutex_lock(&job.lock);
+    job.running -= threads - started; // the workers that couldn't be started never stop
+    threads = started;
+    if (started == 0) // no worker could be started, so the loop runs on this thread
+    {
+        job.running = 1;
+        pthread_mutex_unlock(&job.lock);
+        parallel_worker(&job);
+        pthread_mutex_lock(&job.lock);
+    }
+    while (job.running > 0)
+    {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += PROGRESS_INTERVAL_MS * NANOSECONDS_PER_MS;
+        if (deadline.tv_nsec >= 1000 * NANOSECONDS_PER_MS)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000 * NANOSECONDS_PER_MS;
+        }
+        pthread_cond_timedwait(&job.finished, &job.lock, &deadline);
+
+        if (label != NULL)
+        {
+            printf("%s %d/%d\r", label, atomic_load(&job.done), length); // print current state of processing
+            fflush(stdout);
+        }
+    }
+    pthread_mutex_unlock(&job.lock);
+
+    for (int i = 0; i < threads; i++)
+        pthread_join(workers[i], NULL);
+    free(workers);
+    pthread_mutex_destroy(&job.lock);
+    pthread_cond_destroy(&job.finished);
+}
+
+#endif
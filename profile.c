@@ -0,0 +1,164 @@
+/**
+ * Counters and timers of the hot paths, for the --profile report.
+ * Each thread counts into its own copy, so counting costs no more than a branch and an add when profiling is on and
+ * just the branch when it is off. A worker's copy is added to the totals when it stops, and the calling thread's when
+ * the report is printed.
+ */
+
+#ifndef PROFILE_C
+#define PROFILE_C
+
+#include <pthread.h>
+#include <time.h>
+#include "shared.c"
+
+#define PROGRESS_INTERVAL_MS 100  // the minimum time between progress reports
+#define NANOSECONDS_PER_MS 1000000
+
+/**
+ * The events counted.
+ */
+enum profile_counter
+{
+    COUNT_OUTCOMES,   // answers bucketed by their outcome for a guess
+    COUNT_CANDIDATES, // guesses scored by find_best_guess
+    COUNT_PRUNED,     // guesses find_best_guess skipped on their bound
+    COUNT_CACHED,     // find_best_guess calls answered by the cache
+    COUNT_COLLAPSED,  // guesses find_best_guess skipped as splitting the answers like an earlier one
+    PROFILE_COUNTERS
+};
+
+/**
+ * The operations timed.
+ */
+enum profile_timer
+{
+    TIME_SEARCH, // find_best_guess, when it searches
+    TIME_FILTER, // filter_answers, narrowing the answers by a result
+    TIME_TURN,   // a whole turn, from a result to the next guess
+    TIME_COUNTS, // update_session_counts, counting or removing answers in the outcome counts of an incremental session
+    PROFILE_TIMERS
+};
+
+/**
+ * The counts and times of one thread, or their totals.
+ */
+struct profile
+{
+    unsigned long long counts[PROFILE_COUNTERS];
+    unsigned long long calls[PROFILE_TIMERS];
+    unsigned long long nanoseconds[PROFILE_TIMERS];     // the total time of each operation
+    unsigned long long max_nanoseconds[PROFILE_TIMERS]; // the longest single call of each operation
+};
+
+bool profiling = false;                     // whether --profile was given, set before any thread starts
+_Thread_local struct profile thread_profile; // this thread's counts since it last merged them
+struct profile total_profile;                // the merged counts of every thread
+int profiled_threads = 0;                    // the number of threads merged into total_profile
+pthread_mutex_t profile_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Get the current time for profiling and progress reports.
+ * @return The time in nanoseconds from an arbitrary fixed point.
+ */
+unsigned long long get_nanoseconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * 1000 * NANOSECONDS_PER_MS + now.tv_nsec;
+}
+
+/**
+ * Get whether a progress report is due, at most every PROGRESS_INTERVAL_MS.
+ * @param last The time of the last report, updated when one is due, 0 before the first.
+ * @return Boolean indicating whether to report progress now.
+ */
+bool progress_due(unsigned long long *last)
+{
+    unsigned long long now = get_nanoseconds();
+    if (now - *last < PROGRESS_INTERVAL_MS * NANOSECONDS_PER_MS)
+        return false;
+    *last = now;
+    return true;
+}
+
+/**
+ * Count an event in this thread's profile.
+ * @param counter The event.
+ * @param count The number of times it happened.
+ */
+static inline void profile_count(enum profile_counter counter, unsigned long long count)
+{
+    if (profiling)
+        thread_profile.counts[counter] += count;
+}
+
+/**
+ * Start timing an operation.
+ * @return The start time to pass to profile_stop, or 0 when not profiling.
+ */
+static inline unsigned long long profile_start()
+{
+    return profiling ? get_nanoseconds() : 0;
+}
+
+/**
+ * Finish timing an operation in this thread's profile.
+ * @param timer The operation.
+ * @param start The time profile_start returned.
+ */
+static inline void profile_stop(enum profile_timer timer, unsigned long long start)
+{
+    if (!profiling)
+        return;
+    unsigned long long elapsed = get_nanoseconds() - start;
+    thread_profile.calls[timer]++;
+    thread_profile.nanoseconds[timer] += elapsed;
+    if (elapsed > thread_profile.max_nanoseconds[timer])
+        thread_profile.max_nanoseconds[timer] = elapsed;
+}
+
+/**
+ * Add this thread's profile to the totals, and start it again from zero.
+ */
+void merge_thread_profile()
+{
+    if (!profiling)
+        return;
+    pthread_mutex_lock(&profile_lock);
+    for (int i = 0; i < PROFILE_COUNTERS; i++)
+        total_profile.counts[i] += thread_profile.counts[i];
+    for (int i = 0; i < PROFILE_TIMERS; i++)
+    {
+        total_profile.calls[i] += thread_profile.calls[i];
+        total_profile.nanoseconds[i] += thread_profile.nanoseconds[i];
+        if (thread_profile.max_nanoseconds[i] > total_profile.max_nanoseconds[i])
+            total_profile.max_nanoseconds[i] = thread_profile.max_nanoseconds[i];
+    }
+    profiled_threads++;
+    pthread_mutex_unlock(&profile_lock);
+    memset(&thread_profile, 0, sizeof(thread_profile));
+}
+
+/**
+ * Print the profile of every thread so far, merging in the calling thread's.
+ * @param f The file to print to.
+ */
+void print_profile(FILE *f)
+{
+    const char *counter_names[PROFILE_COUNTERS] = {"outcomes evaluated", "candidates scored", "candidates pruned", "cached searches", "candidates collapsed"};
+    const char *timer_names[PROFILE_TIMERS] = {"find_best_guess", "filter_answers", "turn", "outcome counts"};
+
+    merge_thread_profile();
+    fprintf(f, "profile (merged from %d threads):\n", profiled_threads);
+    for (int i = 0; i < PROFILE_COUNTERS; i++)
+        fprintf(f, "  %-20s %llu\n", counter_names[i], total_profile.counts[i]);
+    for (int i = 0; i < PROFILE_TIMERS; i++)
+    {
+        double total_ms = (double)total_profile.nanoseconds[i] / NANOSECONDS_PER_MS;
+        fprintf(f, "  %-20s %llu calls, %.3lfms total, %.4lfms mean, %.4lfms max\n", timer_names[i], total_profile.calls[i], total_ms,
+                total_profile.calls[i] > 0 ? total_ms / total_profile.calls[i] : 0, (double)total_profile.max_nanoseconds[i] / NANOSECONDS_PER_MS);
+    }
+}
+
+#endif
@@ -0,0 +1,144 @@
+/**
+ * Per thread scratch tables for the searches, so that no table sized by the guesses or outcomes is put on the stack.
+ * Each thread's tables come from one arena sized from the word list the first time the thread searches it, and are
+ * reused by every search after that. A recursive search takes its tables from a level per depth of the recursion,
+ * each allocated the first time the thread reaches that depth. A worker's tables are released when it stops, the main
+ * thread's when the process exits.
+ */
+
+#ifndef SCRATCH_C
+#define SCRATCH_C
+
+#include "shared.c"
+
+/**
+ * The scratch tables of one level of a recursive search, used by the calls at that depth.
+ */
+struct scratch_level
+{
+    int *outcome_counts;          // outcome_count ints
+    int *outcome_order;           // outcome_count ints
+    int *outcome_starts;          // outcome_count + 1 ints
+    unsigned int *outcome_stamps; // outcome_count unsigned ints
+    void *guess_table;            // guess_count records of up to 8 bytes
+    struct arena arena;
+};
+
+/**
+ * The scratch tables of one thread.
+ * Each table is only used within one call of the function it is named for, which calls no other user of it.
+ */
+struct scratch
+{
+    struct word_list *list;         // the word list the tables are sized for, NULL before the first search
+    int *outcome_counts;            // outcome_count ints, the answers of each outcome while bucketing a guess
+    bool *has_answers;              // outcome_count bools, whether each outcome has answers while counting a guess's outcomes
+    int *candidates;                // guess_count ints, the guesses a search checks in the original order
+    int *bounds;                    // guess_count ints, the bound of each candidate
+    int *order;                     // guess_count ints, the order to check the candidates in
+    int *starts;                    // answer_count + 2 ints, where each bound starts while ordering the candidates
+    unsigned long long *signatures; // signature_slots words, the signatures of the guesses a search checked
+    int signature_slots;            // a power of 2 at least twice guess_count
+    struct scratch_level **levels;  // the tables of each depth of a recursive search, NULL until the depth is reached
+    int level_count;                // the number of depths in levels
+    struct arena arena;
+};
+
+_Thread_local struct scratch thread_scratch; // this thread's tables
+
+/**
+ * Release this thread's scratch tables, called by each worker as it stops.
+ */
+void free_thread_scratch()
+{
+    for (int i = 0; i < thread_scratch.level_count; i++)
+    {
+        if (thread_scratch.levels[i] != NULL)
+            free_arena(&thread_scratch.levels[i]->arena);
+        free(thread_scratch.levels[i]);
+    }
+    free(thread_scratch.levels);
+    free_arena(&thread_scratch.arena);
+    memset(&thread_scratch, 0, sizeof(thread_scratch));
+}
+
+/**
+ * Get this thread's scratch tables, sizing them for a word list if they aren't already.
+ * @param list The word list.
+ * @return The tables, or exits if they couldn't be allocated.
+ */
+struct scratch *get_scratch(struct word_list *list)
+{
+    struct scratch *scratch = &thread_scratch;
+    if (scratch->list == list)
+        return scratch;
+
+    free_thread_scratch();
+    int slots = 1;
+    while (slots < 2 * list->guess_count)
+        slots *= 2;
+    size_t sizes[] = {sizeof(int) * list->outcome_count, sizeof(bool) * list->outcome_count, sizeof(int) * list->guess_count,
+                      sizeof(int) * list->guess_count, sizeof(int) * list->guess_count, sizeof(int) * (list->answer_count + 2),
+                      sizeof(unsigned long long) * slots};
+    size_t total = 0;
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+        total += get_arena_size(sizes[i]);
+    if (!init_arena(&scratch->arena, total))
+    {
+        printf("** ERROR: could not allocate %zu bytes of search tables **\n", total);
+        exit(1);
+    }
+
+    scratch->list = list;
+    scratch->outcome_counts = arena_alloc(&scratch->arena, sizes[0]);
+    scratch->has_answers = arena_alloc(&scratch->arena, sizes[1]);
+    scratch->candidates = arena_alloc(&scratch->arena, sizes[2]);
+    scratch->bounds = arena_alloc(&scratch->arena, sizes[3]);
+    scratch->order = arena_alloc(&scratch->arena, sizes[4]);
+    scratch->starts = arena_alloc(&scratch->arena, sizes[5]);
+    scratch->signatures = arena_alloc(&scratch->arena, sizes[6]);
+    scratch->signature_slots = slots;
+    return scratch;
+}
+
+/**
+ * Get this thread's scratch tables for one depth of a recursive search, sizing them for a word list if they aren't already.
+ * @param list The word list.
+ * @param level The depth, at least 0, a call must not share its level with any call it makes.
+ * @return The tables, or exits if they couldn't be allocated.
+ */
+struct scratch_level *get_scratch_level(struct word_list *list, int level)
+{
+    struct scratch *scratch = get_scratch(list);
+    if (level >= scratch->level_count)
+    {
+        scratch->levels = realloc(scratch->levels, sizeof(struct scratch_level *) * (level + 1));
+        for (int i = scratch->level_count; i <= level; i++)
+            scratch->levels[i] = NULL;
+        scratch->level_count = level + 1;
+    }
+    if (scratch->levels[level] != NULL)
+        return scratch->levels[level];
+
+    size_t sizes[] = {sizeof(int) * list->outcome_count, sizeof(int) * list->outcome_count, sizeof(int) * (list->outcome_count + 1),
+                      sizeof(unsigned int) * list->outcome_count, sizeof(unsigned long long) * list->guess_count};
+    size_t total = 0;
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+        total += get_arena_size(sizes[i]);
+    struct scratch_level *tables = malloc(sizeof(struct scratch_level));
+    if (tables == NULL || !init_arena(&tables->arena, total))
+    {
+        printf("** ERROR: could not allocate %zu bytes of search tables **\n", total);
+        exit(1);
+    }
+
+    tables->outcome_counts = arena_alloc(&tables->arena, sizes[0]);
+    tables->outcome_order = arena_alloc(&tables->arena, sizes[1]);
+    tables->outcome_starts = arena_alloc(&tables->arena, sizes[2]);
+    tables->outcome_stamps = arena_alloc(&tables->arena, sizes[3]);
+    tables->guess_table = arena_alloc(&tables->arena, sizes[4]);
+    scratch->levels[level] = tables;
+    return tables;
+}
+
+#endif
@@ -0,0 +1,173 @@
+/**
+ * Precomputed second guesses for a list of first guesses, stored in a small indexed binary file.
+ * For each first guess the table holds the best second guess for every outcome, so turn two, the slowest search of a game,
+ * is a lookup for any of those first guesses. The file is memory mapped like a decision tree.
+ */
+
+#ifndef SECONDS_C
+#define SECONDS_C
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "feedback.c"
+
+#define SECONDS_FILE "second_guesses.bin" // second guess table file name
+#define SECONDS_MAGIC "WRDLSEC1"          // identifies a second guess table file
+
+/**
+ * The header at the start of a second guess table file, followed by the sorted first guesses and then their second guesses.
+ */
+struct seconds_header
+{
+    char magic[FEEDBACK_MAGIC_LENGTH]; // SECONDS_MAGIC
+    int version;                       // STRATEGY_VERSION
+    int opener_count;                  // the number of first guesses
+    int outcome_count;                 // the number of second guesses of each first guess, one per outcome
+    int padding;
+    unsigned long long checksum;       // checksum of the words the table was built from
+};
+
+/**
+ * A second guess table, memory mapped from a file.
+ */
+struct second_guesses
+{
+    void *map;       // the mapped file, NULL if no table is loaded
+    size_t map_size; // the size of the mapped file
+    struct seconds_header header;
+    int *openers;    // the index of each first guess, in ascending order
+    int *guesses;    // the second guess of each first guess and outcome, NULL_INDEX where no answer gives the outcome
+};
+
+/**
+ * Check that every index in a mapped second guess table is in range, so a lookup never reads outside the file.
+ * @param list The word list.
+ * @param header The header of the table, whose sizes match the file.
+ * @param openers The first guesses of the table.
+ * @param guesses The second guesses of the table.
+ * @return Boolean indicating whether the table has a row per outcome, ascending first guesses and valid second guesses.
+ */
+bool check_second_guesses(struct word_list *list, struct seconds_header *header, int *openers, int *guesses)
+{
+    if (header->outcome_count != list->outcome_count)
+        return false;
+    for (int i = 0; i < header->opener_count; i++)
+    {
+        if (openers[i] < 0 || openers[i] >= list->guess_count || (i > 0 && openers[i] <= openers[i - 1]))
+            return false;
+    }
+    for (size_t i = 0; i < (size_t)header->opener_count * header->outcome_count; i++)
+    {
+        if (guesses[i] != NULL_INDEX && (guesses[i] < 0 || guesses[i] >= list->guess_count))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Memory map a second guess table file.
+ * @param table The table to load into.
+ * @param file_name The name of the file.
+ * @param list The current word list, the table is rejected if it was built from different words or has an index out of range.
+ * @return Boolean indicating whether the table was loaded, if not the table is left empty.
+ */
+bool load_second_guesses(struct second_guesses *table, char *file_name, struct word_list *list)
+{
+    memset(table, 0, sizeof(*table));
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size >= (off_t)sizeof(struct seconds_header))
+        map = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping stays valid after the file is closed
+    if (map == MAP_FAILED)
+        return false;
+
+    struct seconds_header *header = map;
+    int *openers = (int *)(header + 1);
+    int *guesses = openers + header->opener_count;
+    size_t expected_size = sizeof(struct seconds_header) + sizeof(int) * (size_t)header->opener_count * (1 + (size_t)header->outcome_count);
+    if (memcmp(header->magic, SECONDS_MAGIC, FEEDBACK_MAGIC_LENGTH) != 0 || header->version != STRATEGY_VERSION ||
+        header->checksum != list->checksum || header->opener_count < 0 || header->outcome_count < 1 || expected_size != (size_t)info.st_size ||
+        !check_second_guesses(list, header, openers, guesses)) // checked once here, so a lookup needs no checks
+    {
+        munmap(map, info.st_size);
+        return false;
+    }
+
+    table->map = map;
+    table->map_size = info.st_size;
+    table->header = *header;
+    table->openers = openers;
+    table->guesses = guesses;
+    return true;
+}
+
+/**
+ * Release a second guess table.
+ * @param table The table to release.
+ */
+void free_second_guesses(struct second_guesses *table)
+{
+    if (table->map != NULL)
+        munmap(table->map, table->map_size);
+    memset(table, 0, sizeof(*table));
+}
+
+/**
+ * Look up the second guess after a first guess and its outcome.
+ * @param table The table, which may be empty or NULL.
+ * @param opener The index of the first guess.
+ * @param outcome The outcome code given for the first guess.
+ * @return The index of the second guess, or NULL_INDEX if the table doesn't have the first guess.
+ */
+int get_second_guess(struct second_guesses *table, int opener, int outcome)
+{
+    if (table == NULL || table->map == NULL)
+        return NULL_INDEX;
+    int low = 0, high = table->header.opener_count - 1;
+    while (low <= high) // binary search the first guesses, which are sorted
+    {
+        int middle = (low + high) / 2;
+        if (table->openers[middle] == opener)
+            return table->guesses[(size_t)middle * table->header.outcome_count + outcome];
+        else if (table->openers[middle] < opener)
+            low = middle + 1;
+        else
+            high = middle - 1;
+    }
+    return NULL_INDEX;
+}
+
+/**
+ * Save a second guess table.
+ * @param file_name The name of the file to save to.
+ * @param checksum The checksum of the words the table was built from.
+ * @param openers The index of each first guess, in ascending order.
+ * @param opener_count The number of first guesses.
+ * @param outcome_count The number of outcomes.
+ * @param guesses The second guess of each first guess and outcome.
+ * @return Boolean indicating whether the table was saved.
+ */
+bool save_second_guesses(char *file_name, unsigned long long checksum, int *openers, int opener_count, int outcome_count, int *guesses)
+{
+    FILE *f = fopen(file_name, "wb");
+    if (f == NULL)
+        return false;
+
+    struct seconds_header header = {.version = STRATEGY_VERSION, .opener_count = opener_count, .outcome_count = outcome_count,
+                                    .checksum = checksum};
+    memcpy(header.magic, SECONDS_MAGIC, FEEDBACK_MAGIC_LENGTH);
+    size_t cells = (size_t)opener_count * outcome_count;
+    bool saved = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(openers, sizeof(int), opener_count, f) == (size_t)opener_count &&
+                 fwrite(guesses, sizeof(int), cells, f) == cells;
+    return fclose(f) == 0 && saved;
+}
+
+#endif
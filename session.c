@@ -0,0 +1,665 @@
+/**
+ * The solver's core as a library: finding the best guess, and playing a game through a session.
+ * A session owns its game state in one block of memory, either its own (session_new) or the caller's (session_init),
+ * and only reads the word list, feedback matrix, decision tree and second guess table, so any number of sessions can be
+ * played at once from any threads. The best guess cache is the only shared state written to, and it is locked.
+ * Nothing here reads input, and only the optional progress report of find_best_guess and find_minimax_guess prints.
+ */
+
+#ifndef SESSION_C
+#define SESSION_C
+
+#include <limits.h>
+#include <stdlib.h>
+#include "cache.c"
+#include "feedback.c"
+#include "profile.c"
+#include "seconds.c"
+#include "tree.c"
+
+/**
+ * Get an upper bound on the number of outcomes a guess can split the available answers into, without checking any answer.
+ * Each letter of the outcome can only be green, orange or black if some available answer allows it.
+ * @param list The word list.
+ * @param guess The index of the guess.
+ * @param answers_left The number of available answers.
+ * @param position_counts The number of available answers with each letter at each position.
+ * @param letter_counts The number of available answers containing each letter.
+ * @return The upper bound, at most answers_left.
+ */
+int get_outcome_bound(struct word_list *list, int guess, int answers_left, int position_counts[list->length][list->alphabet_size],
+                      int letter_counts[list->alphabet_size])
+{
+    unsigned char *letters = get_letters(list, guess);
+    int bound = 1;
+    for (int i = 0; i < list->length && bound < answers_left; i++)
+    {
+        int letter = letters[i];
+        int options = (position_counts[i][letter] > 0) +                         // green, some answer has the letter here
+                      (letter_counts[letter] - position_counts[i][letter] > 0) + // orange, some answer has it, but not here
+                      (position_counts[i][letter] < answers_left);              // black, some answer doesn't have it here
+        bound *= options;
+    }
+    return bound < answers_left ? bound : answers_left;
+}
+
+/**
+ * Count the available answers with each letter at each position, and containing each letter.
+ * @param list The word list.
+ * @param answer_set The set of available answers.
+ * @param position_counts Set to the number of available answers with each letter at each position.
+ * @param letter_counts Set to the number of available answers containing each letter.
+ */
+void count_letters(struct word_list *list, unsigned long long *answer_set, int position_counts[list->length][list->alphabet_size],
+                   int letter_counts[list->alphabet_size])
+{
+    memset(position_counts, 0, sizeof(int) * list->length * list->alphabet_size);
+    memset(letter_counts, 0, sizeof(int) * list->alphabet_size);
+    for (int index = first_in_set(list, answer_set); index != NULL_INDEX; index = next_in_set(list, answer_set, index))
+    {
+        unsigned char *letters = get_letters(list, index); // answers are the first guesses
+        unsigned long long counted = 0;                    // bit i is whether letter i was counted, the alphabet fits in 64 bits
+        for (int i = 0; i < list->length; i++)
+        {
+            int letter = letters[i];
+            position_counts[i][letter]++;
+            if (!(counted >> letter & 1))
+                letter_counts[letter]++;
+            counted |= 1ULL << letter;
+        }
+    }
+}
+
+/**
+ * Get the guesses worth checking in the order to check them: descending get_outcome_bound, and within a bound the original
+ * order, which is the available answers and then every legal guess that isn't one (they would only tie with themselves).
+ * @param list The word list.
+ * @param answer_set The set of available answers.
+ * @param guess_set The set of legal guesses in hard mode, or NULL if every guess is legal.
+ * @param answers_left The number of available answers.
+ * @param position_counts The number of available answers with each letter at each position, from count_letters.
+ * @param letter_counts The number of available answers containing each letter, from count_letters.
+ * @param candidates Set to the index of each candidate in the original order, its rank.
+ * @param bounds Set to the bound of each rank.
+ * @param order Set to the ranks in the order to check them.
+ * @return The number of candidates.
+ */
+int order_candidates(struct word_list *list, unsigned long long *answer_set, unsigned long long *guess_set, int answers_left,
+                     int position_counts[list->length][list->alphabet_size], int letter_counts[list->alphabet_size], int *candidates,
+                     int *bounds, int *order)
+{
+    int total = 0;
+    for (int index = first_in_set(list, answer_set); index != NULL_INDEX; index = next_in_set(list, answer_set, index))
+        candidates[total++] = index;
+    for (int i = 0; i < list->guess_count; i++)
+    {
+        if ((i >= list->answer_count || !in_set(answer_set, i)) && (guess_set == NULL || in_set(guess_set, i)))
+            candidates[total++] = i;
+    }
+
+    // counting sort the candidates by descending bound, keeping the original order within each bound
+    int *starts = get_scratch(list)->starts; // where each bound starts in order, highest bound first, a bound is at most answers_left
+    memset(starts, 0, sizeof(int) * (answers_left + 2));
+    for (int rank = 0; rank < total; rank++)
+    {
+        bounds[rank] = get_outcome_bound(list, candidates[rank], answers_left, position_counts, letter_counts);
+        starts[answers_left + 1 - bounds[rank]]++;
+    }
+    for (int i = 1; i < answers_left + 2; i++)
+        starts[i] += starts[i - 1];
+    for (int rank = total - 1; rank >= 0; rank--)
+        order[--starts[answers_left + 1 - bounds[rank]]] = rank;
+    return total;
+}
+
+/**
+ * Get a signature of a guess against the available answers, such that guesses with the same signature split them alike.
+ * A letter no available answer has is always black, and a letter every available answer has at its position is always green,
+ * so either only adds a constant to every outcome. The second only holds if the guess has the letter once, otherwise the green
+ * takes the answer's letter from the others. Such letters are left out of the signature, and every other letter kept in place.
+ * @param list The word list.
+ * @param guess The index of the guess.
+ * @param constants Whether each letter at each position is always black (1), always green (2) or neither (0) for the available answers.
+ * @return The signature, which fits in 1 + length * (letter_bits + 1) bits, or 0 if the guess has no constant letter
+ * so no other guess has its signature.
+ */
+unsigned long long get_guess_signature(struct word_list *list, int guess, unsigned char constants[list->length][list->alphabet_size])
+{
+    unsigned char *letters = get_letters(list, guess);
+    unsigned long long signature = 1; // a leading 1, so that a guess of only constant letters isn't 0
+    bool has_constant = false;
+    for (int i = 0; i < list->length; i++)
+    {
+        int letter = letters[i];
+        bool constant = constants[i][letter] == 1;
+        if (constants[i][letter] == 2) // always green, unless the guess has the letter elsewhere too
+        {
+            constant = true;
+            for (int j = 0; j < list->length; j++)
+                constant &= j == i || letters[j] != letter;
+        }
+        has_constant |= constant;
+        signature = signature << (list->letter_bits + 1) | (constant ? 0 : letter + 1);
+    }
+    return has_constant ? signature : 0;
+}
+
+/**
+ * Find the next best guess.
+ * Minimising the average amount of answers left is maximising the number of outcomes that have answers left, as the answers
+ * are split between them. Guesses are checked in descending order of an upper bound on that number, and a guess stops being
+ * checked once it can't beat the best guess so far, so the result is the same as checking every guess in full.
+ * On ties the guess checked first by the original order wins, which is the available answers and then every other guess.
+ * Guesses with the same signature as one before them in that order are never checked, as they can only tie with it.
+ * In hard mode only the legal guesses are checked. The available answers are always legal, as they are filtered by the same rule.
+ * @param list The word list and its feedback matrix.
+ * @param answer_set The set of available answers in the current game state.
+ * @param guess_set The set of legal guesses in hard mode, or NULL if every guess is legal.
+ * @param cache The cache of best guesses to look in first and store the result in, or NULL.
+ * @param show_progress Boolean indicating whether to print the current state of processing.
+ * @return The index of the guess that minimises the average amount of answers left.
+ */
+int find_best_guess(struct word_list *list, unsigned long long *answer_set, unsigned long long *guess_set, struct guess_cache *cache, bool show_progress)
+{
+    if (guess_set != NULL) // the cache is keyed by the available answers alone, which don't decide the legal guesses
+        cache = NULL;
+    int cached = cache_lookup(cache, answer_set);
+    if (cached != NULL_INDEX)
+    {
+        profile_count(COUNT_CACHED, 1);
+        return cached;
+    }
+
+    unsigned long long start = profile_start();
+    int answers_left = count_set(list, answer_set);
+    if (answers_left <= list->outcome_count) // the first answer to leave one answer per outcome can't be beaten, or tied earlier
+    {
+        int checked = 0;
+        for (int index = first_in_set(list, answer_set); index != NULL_INDEX; index = next_in_set(list, answer_set, index))
+        {
+            checked++;
+            if (count_outcomes(list, index, answer_set, answers_left, answers_left) == answers_left)
+            {
+                profile_count(COUNT_CANDIDATES, checked);
+                profile_stop(TIME_SEARCH, start);
+                cache_insert(cache, answer_set, index);
+                return index;
+            }
+        }
+        profile_count(COUNT_CANDIDATES, checked);
+    }
+
+    int position_counts[list->length][list->alphabet_size];
+    int letter_counts[list->alphabet_size];
+    count_letters(list, answer_set, position_counts, letter_counts);
+    struct scratch *scratch = get_scratch(list);
+    int *candidates = scratch->candidates, *bounds = scratch->bounds, *order = scratch->order;
+    int total = order_candidates(list, answer_set, guess_set, answers_left, position_counts, letter_counts, candidates, bounds, order);
+
+    // the signatures of the guesses checked, guesses with the same signature have the same bound so are met in the original order
+    bool collapse = 1 + list->length * (list->letter_bits + 1) <= WORD_BITS;
+    unsigned char constants[list->length][list->alphabet_size];
+    for (int i = 0; i < list->length; i++)
+    {
+        for (int letter = 0; letter < list->alphabet_size; letter++)
+            constants[i][letter] = letter_counts[letter] == 0 ? 1 : position_counts[i][letter] == answers_left ? 2 : 0;
+    }
+    int slots = 1, shift = WORD_BITS; // a power of 2 at least twice the candidates, and the shift to hash into it
+    for (; collapse && slots < 2 * total; slots *= 2)
+        shift--;
+    unsigned long long *signatures = scratch->signatures; // open addressing, 0 is an empty slot
+    memset(signatures, 0, sizeof(unsigned long long) * slots);
+
+    int max_outcomes = 0;  // initialise the most outcomes found
+    int best_rank = total; // initialise the original order of the best guess
+    int scored = 0;        // the number of guesses whose outcomes were counted
+    int collapsed = 0;     // the number of guesses skipped for splitting the answers like one checked before
+    unsigned long long last_progress = 0;
+    for (int i = 0; i < total; i++)
+    {
+        int rank = order[i];
+        int needed = rank < best_rank ? max_outcomes : max_outcomes + 1; // outcomes needed to beat the best guess
+        if (bounds[rank] < max_outcomes)
+            break; // every remaining guess has a lower bound, so can't even tie
+        if (bounds[rank] < needed)
+            continue;
+        unsigned long long signature = collapse ? get_guess_signature(list, candidates[rank], constants) : 0;
+        if (signature != 0)
+        {
+            int slot = signature * 0x9E3779B97F4A7C15ULL >> shift;
+            while (signatures[slot] != 0 && signatures[slot] != signature)
+                slot = (slot + 1) & (slots - 1);
+            if (signatures[slot] == signature)
+            {
+                collapsed++; // only the first guess in the original order with this signature can win
+                continue;
+            }
+            signatures[slot] = signature;
+        }
+
+        int outcomes = count_outcomes(list, candidates[rank], answer_set, answers_left, needed);
+        scored++;
+        if (outcomes >= needed && outcomes > 0)
+        {
+            max_outcomes = outcomes;
+            best_rank = rank;
+            if (outcomes == answers_left)
+                break; // if average is 1, shortcut and return immediately (can't get better, or tie earlier)
+        }
+
+        if (!show_progress || !progress_due(&last_progress))
+            continue;
+        printf("Checking %d/%d\r", i + 1, total); // print current state of processing
+        fflush(stdout);                           // flush stdout for cleaner '\r' printing
+    }
+    profile_count(COUNT_CANDIDATES, scored);
+    profile_count(COUNT_PRUNED, total - scored - collapsed);
+    profile_count(COUNT_COLLAPSED, collapsed);
+    profile_stop(TIME_SEARCH, start);
+
+    cache_insert(cache, answer_set, candidates[best_rank]);
+    return candidates[best_rank]; // return the best guess found
+}
+
+/**
+ * Find the guess that minimises the most answers left by any outcome, the guess that does best against an adversary.
+ * Ties go to the guess with the most outcomes, as in find_best_guess, and then to the first guess by the same order.
+ * A guess with at most b outcomes leaves at least answers_left / b answers for some outcome, so guesses are checked in
+ * descending order of the same bound and stop being checked once it can't beat the best guess so far.
+ * @param list The word list and its feedback matrix.
+ * @param answer_set The set of available answers in the current game state.
+ * @param guess_set The set of legal guesses in hard mode, or NULL if every guess is legal.
+ * @param cache The cache of minimax guesses to look in first and store the result in, or NULL. It mustn't hold best guesses.
+ * @param show_progress Boolean indicating whether to print the current state of processing.
+ * @return The index of the guess that minimises the most answers left.
+ */
+int find_minimax_guess(struct word_list *list, unsigned long long *answer_set, unsigned long long *guess_set, struct guess_cache *cache,
+                       bool show_progress)
+{
+    if (guess_set != NULL) // as in find_best_guess
+        cache = NULL;
+    int cached = cache_lookup(cache, answer_set);
+    if (cached != NULL_INDEX)
+    {
+        profile_count(COUNT_CACHED, 1);
+        return cached;
+    }
+
+    unsigned long long start = profile_start();
+    int answers_left = count_set(list, answer_set);
+    int position_counts[list->length][list->alphabet_size];
+    int letter_counts[list->alphabet_size];
+    count_letters(list, answer_set, position_counts, letter_counts);
+    struct scratch *scratch = get_scratch(list);
+    int *candidates = scratch->candidates, *bounds = scratch->bounds, *order = scratch->order;
+    int total = order_candidates(list, answer_set, guess_set, answers_left, position_counts, letter_counts, candidates, bounds, order);
+
+    int min_largest = answers_left + 1; // initialise the fewest most answers left found, beaten by any guess
+    int max_outcomes = 0;               // initialise the outcomes of the best guess
+    int best_rank = total;              // initialise the original order of the best guess
+    int scored = 0;                     // the number of guesses whose outcomes were bucketed
+    unsigned long long last_progress = 0;
+    for (int i = 0; i < total && min_largest > 1; i++) // leaving one answer per outcome can't be beaten, or tied earlier
+    {
+        int rank = order[i];
+        int least_largest = (answers_left + bounds[rank] - 1) / bounds[rank]; // the fewest most answers left possible
+        if (least_largest > min_largest)
+            break; // every remaining guess has a lower bound, so can't even tie
+        if (least_largest == min_largest && (bounds[rank] < max_outcomes || (bounds[rank] == max_outcomes && rank > best_rank)))
+            continue;
+
+        int outcomes;
+        int largest = get_largest_outcome(list, candidates[rank], answer_set, min_largest, &outcomes);
+        scored++;
+        if (largest < min_largest || (largest == min_largest && (outcomes > max_outcomes || (outcomes == max_outcomes && rank < best_rank))))
+        {
+            min_largest = largest;
+            max_outcomes = outcomes;
+            best_rank = rank;
+        }
+
+        if (!show_progress || !progress_due(&last_progress))
+            continue;
+        printf("Checking %d/%d\r", i + 1, total); // print current state of processing
+        fflush(stdout);                           // flush stdout for cleaner '\r' printing
+    }
+    profile_count(COUNT_CANDIDATES, scored);
+    profile_count(COUNT_PRUNED, total - scored);
+    profile_stop(TIME_SEARCH, start);
+
+    cache_insert(cache, answer_set, candidates[best_rank]);
+    return candidates[best_rank];
+}
+
+/**
+ * Find the next best guess from the number of outcomes of every legal guess, without checking any answer.
+ * The guess is the same as find_best_guess's, ties going to the first guess by the same order.
+ * @param list The word list.
+ * @param answer_set The set of available answers in the current game state.
+ * @param guess_set The set of legal guesses in hard mode, or NULL if every guess is legal.
+ * @param outcomes The number of outcomes that have answers left of each legal guess.
+ * @return The index of the guess that minimises the average amount of answers left.
+ */
+int find_counted_guess(struct word_list *list, unsigned long long *answer_set, unsigned long long *guess_set, int *outcomes)
+{
+    int best_guess = NULL_INDEX;
+    int max_outcomes = 0;
+    for (int index = first_in_set(list, answer_set); index != NULL_INDEX; index = next_in_set(list, answer_set, index))
+    {
+        if (outcomes[index] > max_outcomes)
+        {
+            max_outcomes = outcomes[index];
+            best_guess = index;
+        }
+    }
+    for (int i = 0; i < list->guess_count; i++)
+    {
+        if ((i >= list->answer_count || !in_set(answer_set, i)) && (guess_set == NULL || in_set(guess_set, i)) && outcomes[i] > max_outcomes)
+        {
+            max_outcomes = outcomes[i];
+            best_guess = i;
+        }
+    }
+    return best_guess;
+}
+
+/**
+ * Filter the currently available answers to account for a new guess and result.
+ * @param list The word list and its feedback matrix.
+ * @param answer_set The set of currently available answers for the current game state.
+ * @param result The outcome code of the result of the new guess.
+ * @param current_guess The index of the new guess.
+ * @return The total amount of viable answers left.
+ */
+int filter_answers(struct word_list *list, unsigned long long *answer_set, int result, int current_guess)
+{
+    unsigned long long start = profile_start();
+    int answers_left = keep_outcome(list, current_guess, result, answer_set); // only checks the answers still available
+    profile_stop(TIME_FILTER, start);
+    return answers_left;
+}
+
+/**
+ * Filter the legal guesses in hard mode to account for a new guess and result, by the same rule as filter_answers:
+ * a guess stays legal if the new guess would have given this result were it the answer.
+ * @param list The word list and its feedback matrix.
+ * @param guess_set The set of currently legal guesses.
+ * @param result The outcome code of the result of the new guess.
+ * @param current_guess The index of the new guess.
+ */
+void filter_guesses(struct word_list *list, unsigned long long *guess_set, int result, int current_guess)
+{
+    unsigned char *letters = get_letters(list, current_guess);
+    for (int i = 0; i < list->guess_set_words; i++)
+    {
+        for (unsigned long long bits = guess_set[i]; bits != 0; bits &= bits - 1) // for each legal guess in this word of the set
+        {
+            int guess = i * WORD_BITS + __builtin_ctzll(bits);
+            int outcome = guess < list->answer_count ? get_outcome(list, current_guess, guess) // the matrix only has the answers
+                                                     : get_feedback(list, letters, get_letters(list, guess));
+            if (outcome != result)
+                guess_set[i] &= ~(1ULL << (guess % WORD_BITS));
+        }
+    }
+}
+
+
+/**
+ * A game being played: the guess made last and the answers (and in hard mode the legal guesses) it leaves.
+ * An incremental session also keeps the number of answers left giving each outcome for every legal guess, so a search only
+ * has to find the guess with the most outcomes. After each result the counts are either updated by removing the answers it
+ * eliminated or, when fewer answers are left than were eliminated, counted again from those left at the next search.
+ * The sets and counts follow the session in the same block of memory, so a session can be copied or moved as get_session_size bytes.
+ */
+struct session
+{
+    struct word_list *list;         // the word list and its feedback matrix, shared and read only
+    struct decision_tree *tree;     // the decision tree to follow, which may be empty, shared and read only
+    struct second_guesses *seconds; // the second guess table, which may be empty, shared and read only
+    struct guess_cache *cache;      // the cache of best guesses shared between sessions, or NULL
+    bool hard;                      // whether only guesses consistent with every earlier result are made
+    bool minimax;                   // whether each guess minimises the most answers left rather than the average
+    bool incremental;               // whether the outcome counts of every guess are kept between searches
+    bool counted;                   // whether the outcome counts are up to date with the available answers
+    bool show_progress;             // whether to print the progress of each search, for interactive play
+    bool solved;                    // whether the last guess was the answer
+    bool searched;                  // whether the last guess was searched for, rather than looked up or the last answer
+    int guess;                      // the index of the last guess, which the next feedback is for
+    int node;                       // the decision tree node of the last guess, or NULL_INDEX
+    int second;                     // the second guess from the table for the first result, or NULL_INDEX
+    int guesses;                    // the number of guesses made
+    int answers_left;               // the number of answers still available
+    unsigned long long start;       // when the result of the last guess was applied, for profiling the turn
+    unsigned long long sets[];      // the available answers, then in hard mode the legal guesses, then when incremental the counts
+};
+
+/**
+ * Get the memory a session needs.
+ * @param list The word list.
+ * @param hard Boolean indicating whether the session is played in hard mode.
+ * @param incremental Boolean indicating whether the session keeps the outcome counts of every guess.
+ * @return The size of the session, its sets and its counts in bytes.
+ */
+size_t get_session_size(struct word_list *list, bool hard, bool incremental)
+{
+    size_t size = sizeof(struct session) + sizeof(unsigned long long) * (list->set_words + (hard ? list->guess_set_words : 0));
+    if (incremental)
+        size += (sizeof(int) + sizeof(unsigned short) * list->outcome_count) * list->guess_count;
+    return size;
+}
+
+/**
+ * Get the answers still available in a session.
+ * @param session The session.
+ * @return The set of answers.
+ */
+unsigned long long *get_session_answers(struct session *session)
+{
+    return session->sets;
+}
+
+/**
+ * Get the legal guesses in a session.
+ * @param session The session.
+ * @return The set of guesses, or NULL if every guess is legal.
+ */
+unsigned long long *get_session_guesses(struct session *session)
+{
+    return session->hard ? &session->sets[session->list->set_words] : NULL;
+}
+
+/**
+ * Get the number of outcomes that have answers left of each guess in an incremental session.
+ * @param session The session.
+ * @return The outcomes of each guess, only kept up to date for the legal guesses.
+ */
+int *get_session_outcomes(struct session *session)
+{
+    return (int *)&session->sets[session->list->set_words + (session->hard ? session->list->guess_set_words : 0)];
+}
+
+/**
+ * Get the number of answers left giving each outcome for a guess in an incremental session.
+ * @param session The session.
+ * @param guess The index of the guess.
+ * @return The outcome_count counts of the guess.
+ */
+unsigned short *get_session_counts(struct session *session, int guess)
+{
+    unsigned short *counts = (unsigned short *)&get_session_outcomes(session)[session->list->guess_count];
+    return &counts[(size_t)guess * session->list->outcome_count];
+}
+
+/**
+ * Update the outcome counts of every legal guess in an incremental session.
+ * @param session The session.
+ * @param answer_set The answers to add to the counts after clearing them, or to remove from them.
+ * @param add Boolean indicating whether to count the answers from scratch rather than remove them.
+ */
+void update_session_counts(struct session *session, unsigned long long *answer_set, bool add)
+{
+    struct word_list *list = session->list;
+    unsigned long long start = profile_start();
+    unsigned long long *guess_set = get_session_guesses(session);
+    int *outcomes = get_session_outcomes(session);
+    for (int i = 0; i < list->guess_count; i++)
+    {
+        if (guess_set != NULL && !in_set(guess_set, i)) // a guess never becomes legal again, so its counts aren't needed
+            continue;
+        unsigned short *counts = get_session_counts(session, i);
+        if (add)
+        {
+            memset(counts, 0, sizeof(unsigned short) * list->outcome_count);
+            outcomes[i] = 0;
+        }
+        outcomes[i] += update_outcome_counts(list, i, answer_set, counts, add);
+    }
+    profile_stop(TIME_COUNTS, start);
+}
+
+/**
+ * Start a game in memory owned by the caller.
+ * @param session The memory to start the game in, get_session_size bytes aligned for a session.
+ * @param list The word list, whose feedback matrix must already be built.
+ * @param tree The decision tree to follow when it was built for the opener, or NULL. It isn't followed in hard mode.
+ * @param seconds The second guess table to look the second guess up in when it has the opener, or NULL. It isn't used in hard mode.
+ * @param cache The cache of best guesses, or NULL.
+ * @param opener The index of the first guess.
+ * @param hard Boolean indicating whether to play in hard mode.
+ * @param minimax Boolean indicating whether to choose each guess by find_minimax_guess. The tree and the second guess table
+ * hold find_best_guess's guesses, so they aren't used, and the outcome counts aren't kept. The cache is used, so it mustn't
+ * be shared with sessions that aren't minimax.
+ * @param incremental Boolean indicating whether to keep the outcome counts of every guess, which takes get_session_size bytes.
+ * The counts are only kept when there are at most USHRT_MAX answers, otherwise the session searches as usual.
+ */
+void session_init(struct session *session, struct word_list *list, struct decision_tree *tree, struct second_guesses *seconds,
+                  struct guess_cache *cache, int opener, bool hard, bool minimax, bool incremental)
+{
+    if (minimax)
+    {
+        tree = NULL;
+        seconds = NULL;
+        incremental = false;
+    }
+    *session = (struct session){.list = list, .tree = tree, .seconds = hard ? NULL : seconds, .cache = cache, .hard = hard, .minimax = minimax,
+                                .guess = opener, .guesses = 1, .second = NULL_INDEX, .answers_left = list->answer_count,
+                                .incremental = incremental && list->answer_count <= USHRT_MAX};
+    session->node = tree == NULL || hard ? NULL_INDEX : get_tree_root(tree, opener); // the tree was built without the hard mode rule
+    fill_set(list, get_session_answers(session));
+    if (hard)
+        fill_guess_set(list, get_session_guesses(session));
+}
+
+/**
+ * Start a game in its own memory.
+ * @return The session, see session_init for the parameters, or NULL if it couldn't be allocated. Release it with session_free.
+ */
+struct session *session_new(struct word_list *list, struct decision_tree *tree, struct second_guesses *seconds, struct guess_cache *cache,
+                            int opener, bool hard, bool minimax, bool incremental)
+{
+    struct session *session = malloc(get_session_size(list, hard, incremental));
+    if (session != NULL)
+        session_init(session, list, tree, seconds, cache, opener, hard, minimax, incremental);
+    return session;
+}
+
+/**
+ * Release a session from session_new.
+ * @param session The session, or NULL.
+ */
+void session_free(struct session *session)
+{
+    free(session);
+}
+
+/**
+ * Apply the result of the last guess.
+ * @param session The session.
+ * @param outcome The outcome code of the result.
+ * @return The number of answers left, 0 if the results given leave none, and 1 once the last guess was the answer.
+ */
+int session_apply_feedback(struct session *session, int outcome)
+{
+    struct word_list *list = session->list;
+    session->start = profile_start();
+    if (outcome == ALL_GREEN(list))
+    {
+        session->solved = true;
+        return session->answers_left = 1;
+    }
+
+    unsigned long long *answer_set = get_session_answers(session);
+    unsigned long long eliminated[list->set_words]; // the answers before the result, then those it eliminated
+    int answers_before = session->answers_left;
+    if (session->counted)
+        memcpy(eliminated, answer_set, sizeof(eliminated));
+    session->answers_left = filter_answers(list, answer_set, outcome, session->guess);
+    if (session->hard && session->answers_left > 1) // the last answer is always legal, so the guesses are only filtered when there are more
+        filter_guesses(list, get_session_guesses(session), outcome, session->guess);
+    if (session->counted && answers_before - session->answers_left < session->answers_left)
+    {
+        for (int i = 0; i < list->set_words; i++)
+            eliminated[i] &= ~answer_set[i];
+        update_session_counts(session, eliminated, false);
+    }
+    else
+        session->counted = false; // counting the answers left is cheaper, which the next search does
+    session->node = session->node == NULL_INDEX ? NULL_INDEX : get_tree_child(session->tree, session->node, outcome);
+    session->second = session->guesses == 1 ? get_second_guess(session->seconds, session->guess, outcome) : NULL_INDEX;
+    return session->answers_left;
+}
+
+/**
+ * Choose the next guess, from the decision tree when it covers the game, otherwise the last answer, the second guess table
+ * on turn two when it has the opener, or the best guess (the minimax guess for a minimax session).
+ * @param session The session, after session_apply_feedback.
+ * @return The index of the next guess, which the next feedback is for, or NULL_INDEX if the game is solved or has no answers left.
+ */
+int session_next_guess(struct session *session)
+{
+    if (session->solved || session->answers_left == 0)
+        return NULL_INDEX;
+
+    struct word_list *list = session->list;
+    session->searched = false;
+    if (session->node != NULL_INDEX)
+        session->guess = session->tree->nodes[session->node].guess;
+    else if (session->answers_left == 1)
+        session->guess = first_in_set(list, get_session_answers(session));
+    else if (session->second != NULL_INDEX)
+        session->guess = session->second;
+    else if (session->minimax)
+    {
+        session->guess = find_minimax_guess(list, get_session_answers(session), get_session_guesses(session), session->cache,
+                                           session->show_progress);
+        session->searched = true;
+    }
+    else if (!session->incremental)
+    {
+        session->guess = find_best_guess(list, get_session_answers(session), get_session_guesses(session), session->cache, session->show_progress);
+        session->searched = true;
+    }
+    else
+    {
+        struct guess_cache *cache = session->hard ? NULL : session->cache; // as in find_best_guess
+        session->guess = cache_lookup(cache, get_session_answers(session));
+        if (session->guess == NULL_INDEX)
+        {
+            unsigned long long start = profile_start();
+            if (!session->counted)
+                update_session_counts(session, get_session_answers(session), true);
+            session->counted = true;
+            session->guess = find_counted_guess(list, get_session_answers(session), get_session_guesses(session), get_session_outcomes(session));
+            cache_insert(cache, get_session_answers(session), session->guess);
+            profile_stop(TIME_SEARCH, start);
+        }
+        else
+            profile_count(COUNT_CACHED, 1);
+        session->searched = true;
+    }
+    session->guesses++;
+    profile_stop(TIME_TURN, session->start);
+    return session->guess;
+}
+
+#endif
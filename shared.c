@@ -1,16 +1,19 @@
+#ifndef SHARED_C
+#define SHARED_C
+
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
 
 #define ANSWERS_FILE "answers.txt" // answers file name
 #define GUESSES_FILE "guesses.txt" // guesses file name
-#define ANSWER_LENGTH 2315         // the amount of valid answers wordle has
-#define GUESSES_LENGTH 12972       // the amount of valid guesses wordle allows
 
-#define WORD_SIZE 6      // the total word size of each word (5 + escaping)
-#define ALPHABET_SIZE 26 // the total size of the alphabet the words derive from
+#define FAST_PATH_LENGTH 5    // the usual number of letters in a word, which the kernels are specialised for
+#define MAX_WORD_LENGTH 10    // the most letters in a word, so that every outcome code fits in 16 bits
+#define MAX_ALPHABET_SIZE 64  // the most letters in an alphabet
+#define MAX_LETTER_SIZE 5     // the most bytes of a letter (one UTF-8 character) + escaping
 
-#define TOTAL_OUTCOMES 243 // the total number of outcomes possible in wordle
 #define OUTCOMES_LENGTH 3  // the total number of options for each letter in an outcome
 
 #define GREEN 2            // the green integer used in replacement of the green character
@@ -19,155 +22,133 @@
 
 #define NULL_INDEX -1 // index used to identify when we've hit the end of an integer array
 
+#define ARENA_ALIGNMENT 64 // every allocation from an arena starts on a cache line
 
 /**
- * Counts the number of a particular character in a string.
- * @param string The string to look in.
- * @param n The number of characters in the string.
- * @param character The character to look for.
- * @return The number of this character in the string.
+ * One block of memory that a known set of tables is carved out of, and released with in one go.
  */
-int count_chr(char *string, int n, char character)
+struct arena
 {
-    int count = 0;
-    for (int i = 0; i < n; i++)
-    {
-        if (string[i] == character)
-            count++;
-    }
-    return count;
+    char *base;  // the block
+    size_t size; // the size of the block
+    size_t used; // the bytes handed out so far
+};
+
+/**
+ * The answers and guesses in use, and every table built from them.
+ * Sizes are read when the words are loaded, and every table is allocated from the arena.
+ */
+struct word_list
+{
+    int answer_count;                  // the number of answers
+    int guess_count;                   // the number of guesses, which start with the answers in the same order
+    int length;                        // the number of letters in each word
+    int alphabet_size;                 // the number of letters in the alphabet
+    int letter_bits;                   // the number of bits of each letter in a word code
+    int outcome_count;                 // the number of outcomes, OUTCOMES_LENGTH ^ length
+    int outcome_size;                  // the bytes of each outcome code in the feedback matrix, 1 up to 5 letters (the fast path) or 2
+    int set_words;                     // the number of words in a set of answers
+    int guess_set_words;               // the number of words in a set of guesses
+    int text_size;                     // the bytes of each word written out, including escaping
+    unsigned long long checksum;       // checksum of the words, identifies files built from them
+    char (*alphabet)[MAX_LETTER_SIZE]; // the text of each letter, in byte order
+    unsigned char *letters;            // letters[i * length + j] is letter j of guess i, as an index into alphabet
+    char *text;                        // text[i * text_size] is guess i written out
+    void *feedback;                    // the feedback matrix, filled in by get_feedback_matrix
+    unsigned long long *codes;         // the code of every guess, used by the word index
+    int *slots;                        // the word index, the guess in each slot or NULL_INDEX
+    int slot_mask;                     // the number of slots - 1, the number of slots is a power of 2
+    signed char byte_letters[256];     // the letter of each single byte letter, or NULL_INDEX
+    struct arena arena;
+};
+
+/**
+ * Round the size of an allocation up to where the next one would start in an arena.
+ * @param size The size of the allocation.
+ * @return The space it takes up in the arena.
+ */
+size_t get_arena_size(size_t size)
+{
+    return (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
 }
 
 /**
- * Get the valid answers and valid guesses from their respective files.
- * @param answers The array to store the valid answers.
- * @param guesses The array to store the valid guesses.
+ * Allocate an arena.
+ * @param arena The arena to set up.
+ * @param size The size of the arena, the sum of get_arena_size of every allocation to be made from it.
+ * @return Boolean indicating whether the arena was allocated.
  */
-void get_answers_guesses(char answers[][WORD_SIZE], char guesses[][WORD_SIZE])
+bool init_arena(struct arena *arena, size_t size)
 {
-    FILE *f = fopen(ANSWERS_FILE, "r");
-    for (int i = 0; i < ANSWER_LENGTH; i++)
-    {
-        char other[WORD_SIZE]; // use to store empty new line string
-        fgets(answers[i], WORD_SIZE, f);
-        strcpy(guesses[i], answers[i]);
-        fgets(other, WORD_SIZE, f);
-    }
-    fclose(f);
+    arena->base = aligned_alloc(ARENA_ALIGNMENT, get_arena_size(size > 0 ? size : 1));
+    arena->size = size;
+    arena->used = 0;
+    return arena->base != NULL;
+}
 
-    f = fopen(GUESSES_FILE, "r");
-    for (int i = 0; i < GUESSES_LENGTH; i++)
-    {
-        char other[WORD_SIZE]; // use to store empty new line string
-        fgets(guesses[i + ANSWER_LENGTH], WORD_SIZE, f);
-        fgets(other, WORD_SIZE, f);
-    }
-    fclose(f);
+/**
+ * Allocate from an arena.
+ * @param arena The arena.
+ * @param size The size of the allocation.
+ * @return The allocation, or NULL if the arena doesn't have room for it.
+ */
+void *arena_alloc(struct arena *arena, size_t size)
+{
+    size = get_arena_size(size);
+    if (size > arena->size - arena->used)
+        return NULL;
+    void *allocation = arena->base + arena->used;
+    arena->used += size;
+    return allocation;
 }
 
 /**
- * Get all possible outcomes of any given word.
- * @param outcomes The array to store all possible outcomes.
+ * Release an arena, and everything allocated from it.
+ * @param arena The arena to release.
  */
-void get_all_possible_outcomes(int outcomes[TOTAL_OUTCOMES][WORD_SIZE - 1])
+void free_arena(struct arena *arena)
 {
-    for (int i = 0; i < TOTAL_OUTCOMES; i++)
-    {
-        int num = i;
-        for (int j = 0; j < WORD_SIZE - 1; j++) // get the ternary representation of i for outcomes[i]
-        {
-            outcomes[i][WORD_SIZE - 1 - j - 1] = num % OUTCOMES_LENGTH;
-            num /= OUTCOMES_LENGTH;
-        }
-    }
+    free(arena->base);
+    memset(arena, 0, sizeof(*arena));
 }
 
 /**
- * Check if an answer is possible, given a guess and its outcome.
- * @param answer The answer to check.
- * @param guess The guess.
- * @param outcome The outcome.
- * @return Boolean indicating whether the answer is possible.
+ * Get the letters of a guess.
+ * @param list The word list.
+ * @param index The index of the guess.
+ * @return The letters of the guess, each an index into the alphabet.
  */
-bool is_possible(char answer[WORD_SIZE], char guess[WORD_SIZE], int outcome[WORD_SIZE - 1])
+unsigned char *get_letters(struct word_list *list, int index)
 {
-    int order[OUTCOMES_LENGTH][WORD_SIZE]; // compartmentalise the outcomes
-    int a = 0, b = 0, c = 0;
-    for (int i = 0; i < WORD_SIZE - 1; i++)
-    {
-        if (outcome[i] == GREEN)
-            order[0][a++] = i; // green at index 0
-        else if (outcome[i] == ORANGE)
-            order[1][b++] = i; // orange at index 1
-        else
-            order[2][c++] = i; // blacks at index 2
-    }
-    // add a null index to each array to indicate where to stop
-    order[0][a] = NULL_INDEX;
-    order[1][b] = NULL_INDEX;
-    order[2][c] = NULL_INDEX;
+    return &list->letters[(size_t)index * list->length];
+}
 
-    int checked[ALPHABET_SIZE] = {}; // store the characters that have been checked
+/**
+ * Get a guess written out.
+ * @param list The word list.
+ * @param index The index of the guess.
+ * @return The text of the guess.
+ */
+char *get_word(struct word_list *list, int index)
+{
+    return &list->text[(size_t)index * list->text_size];
+}
 
-    for (int i = 0; i < OUTCOMES_LENGTH; i++)
+/**
+ * Get the number of bytes of the letter at the start of some text.
+ * @param text The text, UTF-8 encoded.
+ * @return The number of bytes of the first character, or 0 at the end of the text.
+ */
+int get_letter_size(char *text)
+{
+    unsigned char first = text[0];
+    int size = first == '\0' ? 0 : first < 0xC0 ? 1 : first < 0xE0 ? 2 : first < 0xF0 ? 3 : 4;
+    for (int i = 1; i < size; i++)
     {
-        int j = 0;
-        while (order[i][j] != NULL_INDEX)
-        {
-            int index = order[i][j];
-            int count = count_chr(answer, WORD_SIZE, guess[index]);
-            int checked_index = guess[index] - 'a' + 1; // index for the checked array
-
-            // if the outcome is green, check if answer contains guess[index] at position index and add to checked
-            if (outcome[index] == GREEN)
-            {
-                if (answer[index] != guess[index]) // answer must contain the letter at the index
-                    return false;
-
-                checked[checked_index]++;
-            }
-
-            // if outcome is orange, two scenarios are possible
-            // - the letter hasn't been checked yet, therefore if the answer contains this letter or has the letter at index it is invalid
-            // - the letter has been checked, therefore if we already checked the amount of the letter or the answer contains this letter at index it is invalid
-            else if (outcome[index] == ORANGE)
-            {
-                if (checked[checked_index] == 0) // no greens of this letter have been checked yet for the letter in question
-                {
-                    if (count == 0 || guess[index] == answer[index]) // answer must contain the letter, not at the same index
-                        return false;
-                }
-
-                else // some greens of this letter have been checked
-                {
-                    if (checked[checked_index] == count || guess[index] == answer[index])
-                        return false; // answer must contain only count of the letter, and not at the same index
-                }
-                checked[checked_index]++;
-            }
-
-            // if outcome is black, three scenarios are possible
-            // - there is no count of the letter in question, which means this answer is valid so far
-            // - there is count of the letter and we haven't already checked this letter, meaning this answer is invalid
-            // - there is count of the letter and we have checked the letter, and the number of checked is less than the count, meaning answer is invalid
-            else
-            {
-                if (count != 0) // there is count of the letter
-                {
-                    if (checked[checked_index] == 0) // if no greens or oranges of this letter checked yet
-                        return false;
-                    else // greens or oranges of this letter have been checked
-                    {
-                        if (checked[checked_index] < count) // ensure we are not below the count of the letter
-                        {
-                            return false;
-                        }
-                    }
-                }
-            }
-            j++;
-        }
+        if (text[i] == '\0') // a truncated character is taken as it is
+            return i;
     }
+    return size;
+}
 
-    return true; // answer passes validation
-}
\ No newline at end of file
+#endif
@@ -5,18 +5,34 @@
  * @note This implementation was originally translated from Python
  */
 
-#include "shared.c"
+#include <time.h>
+#include "cache.c"
+#include "dictionary.c"
+#include "optimal.c"
+#include "parallel.c"
+#include "session.c"
+#include "tree.c"
 
-#define ANSWER_LENGTH 2315   // the amount of valid answers wordle has
-#define GUESSES_LENGTH 12972 // the amount of valid guesses wordle allows
-
-#define WORD_SIZE 6 // the total word size of each word (5 + escaping)
-
-#define TOTAL_OUTCOMES 243 // the total number of outcomes possible in wordle
 #define GREEN_INPUT 'g'    // the green input character
 #define ORANGE_INPUT 'o'   // the orange input character
 #define BLACK_INPUT '-'    // the black input character
 
+#define DEFAULT_OPENER "trace" // the first guess used in batch mode, the best first guess in first_guess.txt
+#define FIRST_GUESS_FILE "first_guess.txt" // the best first guesses, written by first_guess.c
+#define MAX_GUESSES 6          // games taking more guesses than this are failures
+#define MAX_BATCH_GUESSES 20   // the number of guesses after which a batch game is given up on
+#define NANOSECONDS_PER_SECOND 1e9
+#define DEFAULT_CACHE_MB 64    // the best guess cache budget when only --cache-file is given, or in server mode
+#define SESSION_ID_SIZE 64     // the longest session id in server mode (including escaping)
+#define SESSION_BUCKETS 1024   // the initial number of session hash buckets, a power of 2
+#define MAX_BOARDS 32          // the most boards solved at once in multi-board mode
+#define DEFAULT_TOP_K 20       // the most guesses tried for each set of answers by the optimal search
+#define DEFAULT_MEMO_MB 256    // the optimal search memo budget
+#define INGEST_BUFFER_BYTES (4 << 20) // the read buffer of --ingest, the longest game line it takes
+#define INGEST_BLOCK_GAMES 65536      // the most games of a log replayed at once
+#define INGEST_REPORT_GUESSES 8       // the guesses after which --ingest reports the mean answers left
+#define AUDIT_REPORT_ANSWERS 10       // the most worst case answers --worst-case lists
+
 /**
  * Converts a character into it's lowercase equivalent.
  * @param character The character to convert.
@@ -31,262 +47,1943 @@ char to_lower(char character)
     return character;
 }
 
+/**
+ * Read a line of the user's input, skipping blank lines.
+ * @param prompt The prompt to print before reading.
+ * @param line The array to store the line in, without its line ending.
+ * @param size The size of line.
+ * @return Boolean indicating whether a line was read, false at the end of the input.
+ */
+bool read_line(char *prompt, char *line, int size)
+{
+    do
+    {
+        printf("%s", prompt);
+        if (fgets(line, size, stdin) == NULL)
+            return false;
+        line[strcspn(line, "\r\n")] = '\0';
+    } while (line[0] == '\0');
+    return true;
+}
+
 /**
  * Get the first guess from the user's input.
- * @param guesses The valid guesses the user can choose from.
- * @return The user's first guess.
+ * @param list The word list the user can choose from.
+ * @return The index of the user's first guess in guesses, or NULL_INDEX at the end of the input.
  */
-char *get_first_guess(char guesses[][WORD_SIZE])
+int get_first_guess(struct word_list *list)
 {
-    static char first_guess[WORD_SIZE];
+    char first_guess[BUFSIZ];
     printf("\n");
+    while (read_line(" GUESS: ", first_guess, sizeof(first_guess)))
+    {
+        int index = find_word(list, first_guess);
+        if (index != NULL_INDEX) // if we find the input in guesses return it
+            return index;
+
+        printf("** invalid first guess **\n"); // if we haven't found the input in guesses, print error message and retry
+    }
+    return NULL_INDEX;
+}
+
+/**
+ * Parse a result written as GREEN_INPUT, ORANGE_INPUT and BLACK_INPUT characters.
+ * @param list The word list, which sets the length of a result.
+ * @param text The result, in any case.
+ * @return The outcome code of the result, or NULL_INDEX if it isn't a valid result.
+ */
+int parse_result(struct word_list *list, char *text)
+{
+    if (strlen(text) != (size_t)list->length)
+        return NULL_INDEX;
+
+    int outcome[MAX_WORD_LENGTH];
+    for (int i = 0; i < list->length; i++)
+    {
+        char c = to_lower(text[i]);
+        if (c == GREEN_INPUT)
+            outcome[i] = GREEN;
+        else if (c == ORANGE_INPUT)
+            outcome[i] = ORANGE;
+        else if (c == BLACK_INPUT)
+            outcome[i] = BLACK;
+        else
+            return NULL_INDEX;
+    }
+    return get_outcome_code(list, outcome);
+}
+
+/**
+ * Write a result as GREEN_INPUT, ORANGE_INPUT and BLACK_INPUT characters.
+ * @param list The word list, which sets the length of a result.
+ * @param outcome The outcome code of the result.
+ * @param text The array to write the result to, at least length + 1 characters.
+ */
+void format_result(struct word_list *list, int outcome, char *text)
+{
+    for (int i = list->length - 1; i >= 0; i--, outcome /= OUTCOMES_LENGTH) // the first letter is the most significant digit
+    {
+        int digit = outcome % OUTCOMES_LENGTH;
+        text[i] = digit == GREEN ? GREEN_INPUT : digit == ORANGE ? ORANGE_INPUT : BLACK_INPUT;
+    }
+    text[list->length] = '\0';
+}
+
+/**
+ * Get the result from the last guess from the user's input.
+ * @param list The word list, which sets the length of a result.
+ * @param prompt The prompt to print before reading.
+ * @return The outcome code of the result, or NULL_INDEX at the end of the input.
+ */
+int get_result(struct word_list *list, char *prompt)
+{
+    char result[BUFSIZ];
+    while (read_line(prompt, result, sizeof(result)))
+    {
+        int outcome = parse_result(list, result);
+        if (outcome != NULL_INDEX)
+            return outcome;               // if input was valid, return the result
+        printf("** invalid result **\n"); // otherwise print error message and retry
+    }
+    return NULL_INDEX;
+}
+
+/**
+ * Solve for a word, reading the result of each guess and printing the next.
+ * @param session The game, after its first guess.
+ * @return The solution, or NULL if invalid results left no answers or the input ended.
+ */
+char *solve_word(struct session *session)
+{
+    struct word_list *list = session->list;
     while (1)
     {
-        printf(" GUESS: ");
+        int outcome = get_result(list, "RESULT: "); // get the result from the current guess
+        if (outcome == NULL_INDEX)                  // the input ended before the game did
+            return NULL;
+
+        int answers_left = session_apply_feedback(session, outcome); // filter the answers to find how many answers are left
+        if (session->solved)                                         // if the current guess is correct, return it
+            return get_word(list, session->guess);
+        printf("-- answers left: %d --\n\n", answers_left); // otherwise print the amount of answers left
+        if (answers_left == 0)                              // if we have no answers left, an error has occured so return null
+            return NULL;
+
+        int next_guess = session_next_guess(session); // follow the decision tree, or find the next best guess
+        if (answers_left == 1)                        // if we have one answer left, return it
+            return get_word(list, next_guess);
+        printf(" GUESS: %s         \n", get_word(list, next_guess)); // print it out and keep solving
+    }
+}
+
+/**
+ * The data shared by every worker scoring guesses across several boards.
+ */
+struct board_scoring
+{
+    struct word_list *list;           // the word list and its feedback matrix
+    unsigned long long **answer_sets; // the set of available answers of each unsolved board
+    int board_count;                  // the number of unsolved boards
+    double *scores;                   // the score of each guess, the sum over the boards of the average answers left
+};
+
+/**
+ * Score one guess across every unsolved board.
+ * The boards are scored together, so the guess's feedback matrix row is read once and stays cached for every board.
+ * @param index The index of the guess.
+ * @param context The board scoring to store the score in.
+ */
+void score_board_guess(int index, void *context)
+{
+    struct board_scoring *scoring = context;
+    double score = 0;
+    for (int i = 0; i < scoring->board_count; i++)
+        score += score_guess(scoring->list, index, scoring->answer_sets[i]);
+    scoring->scores[index] = score;
+}
+
+/**
+ * Find the next best guess across several boards, the guess minimising the total of the average answers left on each board.
+ * A board with one answer left is solved first, as no guess can do better on it. On ties the guess checked first wins,
+ * which is the available answers of any board and then every other guess, so the result doesn't depend on the threads.
+ * @param list The word list and its feedback matrix.
+ * @param answer_sets The set of available answers of each unsolved board.
+ * @param board_count The number of unsolved boards.
+ * @param threads The number of worker threads to score the guesses with.
+ * @return The index of the best guess.
+ */
+int find_best_board_guess(struct word_list *list, unsigned long long **answer_sets, int board_count, int threads)
+{
+    unsigned long long any_set[list->set_words]; // the answers available on any board
+    memset(any_set, 0, sizeof(any_set));
+    for (int i = 0; i < board_count; i++)
+    {
+        if (count_set(list, answer_sets[i]) == 1)
+            return first_in_set(list, answer_sets[i]);
+        for (int j = 0; j < list->set_words; j++)
+            any_set[j] |= answer_sets[i][j];
+    }
 
-        for (int i = 0; i < WORD_SIZE - 1; i++) // get five characters
+    double *scores = malloc(sizeof(double) * list->guess_count);
+    struct board_scoring scoring = {list, answer_sets, board_count, scores};
+    parallel_for(list->guess_count, threads, score_board_guess, &scoring, "Checking");
+
+    int best = first_in_set(list, any_set);
+    for (int index = next_in_set(list, any_set, best); index != NULL_INDEX; index = next_in_set(list, any_set, index))
+    {
+        if (scores[index] < scores[best])
+            best = index;
+    }
+    for (int i = 0; i < list->guess_count; i++)
+    {
+        if ((i >= list->answer_count || !in_set(any_set, i)) && scores[i] < scores[best])
+            best = i;
+    }
+    free(scores);
+    return best;
+}
+
+/**
+ * Solve for several words at once, every guess being made on every board that isn't solved yet.
+ * @param list The word list and its feedback matrix.
+ * @param board_count The number of boards.
+ * @param first_guess The index of the first guess.
+ * @param threads The number of worker threads to score the guesses with.
+ * @return 0 once every board is solved, 1 if invalid results left a board with no answers or the input ended.
+ */
+int solve_boards(struct word_list *list, int board_count, int first_guess, int threads)
+{
+    unsigned long long answer_sets[board_count][list->set_words]; // the available answers of each board
+    int solutions[board_count];                                   // the answer of each board, or NULL_INDEX until it is solved
+    for (int i = 0; i < board_count; i++)
+    {
+        fill_set(list, answer_sets[i]);
+        solutions[i] = NULL_INDEX;
+    }
+
+    int guess = first_guess;
+    int total_guesses = 1;
+    int unsolved = board_count;
+    while (1)
+    {
+        for (int i = 0; i < board_count; i++) // get the result of the guess on each unsolved board
         {
-            char c = to_lower(getchar());
-            if (c == '\n') // skip end line character
-            {
-                i--;
+            if (solutions[i] != NULL_INDEX)
                 continue;
+            char prompt[32];
+            sprintf(prompt, "RESULT %d: ", i + 1);
+            int outcome = get_result(list, prompt);
+            if (outcome == NULL_INDEX)
+                return 1;
+            if (outcome == ALL_GREEN(list))
+            {
+                solutions[i] = guess;
+                unsolved--;
+            }
+            else if (filter_answers(list, answer_sets[i], outcome, guess) == 0)
+            {
+                printf("** ERROR: no answers left on board %d - invalid result(s) **\n", i + 1);
+                return 1;
             }
-            first_guess[i] = c;
         }
-        first_guess[WORD_SIZE - 1] = '\0';
+        if (unsolved == 0)
+            break;
 
-        for (int i = 0; i < GUESSES_LENGTH; i++)
+        unsigned long long start = profile_start(); // time the turn once every result is entered
+        unsigned long long *unsolved_sets[board_count];
+        int count = 0;
+        printf("-- answers left:");
+        for (int i = 0; i < board_count; i++)
         {
-            if (strcmp(guesses[i], first_guess) == 0) // if we find the input in guesses return it
-                return first_guess;
+            if (solutions[i] != NULL_INDEX)
+            {
+                printf(" -");
+                continue;
+            }
+            printf(" %d", count_set(list, answer_sets[i]));
+            unsolved_sets[count++] = answer_sets[i];
         }
+        printf(" --\n\n");
 
-        printf("** invalid first guess **\n"); // if we haven't found the input in guesses, print error message and retry
+        guess = find_best_board_guess(list, unsolved_sets, count, threads);
+        profile_stop(TIME_TURN, start);
+        total_guesses++;
+        printf(" GUESS: %s         \n", get_word(list, guess));
     }
+
+    printf("** ANSWERS:");
+    for (int i = 0; i < board_count; i++)
+        printf(" %s", get_word(list, solutions[i]));
+    printf(" - Guesses: %d **\n\n", total_guesses);
+    return 0;
 }
 
 /**
- * Get the result from the last guess from the user's input.
- * @return Pointer to the result array.
+ * The results of a batch of games.
  */
-int *get_result()
+struct batch_results
 {
-    static int result[WORD_SIZE - 1];
-    while (1)
+    int games;                            // the number of games played
+    int histogram[MAX_BATCH_GUESSES + 1]; // the number of games solved in each number of guesses
+    int unsolved;                         // the number of games given up on after MAX_BATCH_GUESSES guesses
+    long total_guesses;                   // the total guesses over all solved games
+    double *game_times;                   // the wall time of each game in seconds
+    double *search_times;                 // the wall time of each find_best_guess call in seconds
+    int searches;                         // the number of find_best_guess calls
+};
+
+/**
+ * Get the current time.
+ * @return The time in seconds from an arbitrary fixed point.
+ */
+double get_time()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / NANOSECONDS_PER_SECOND;
+}
+
+/**
+ * A batch of games being played, shared by every worker.
+ */
+struct batch
+{
+    struct word_list *list;         // the word list and its feedback matrix
+    int *answers;                   // the index of the answer of each game
+    int opener;                     // the index of the first guess
+    bool hard;                      // whether to play in hard mode
+    bool minimax;                   // whether to choose each guess by find_minimax_guess
+    bool incremental;               // whether each game keeps the outcome counts of every guess between searches
+    struct decision_tree *tree;     // the decision tree to follow, which may be empty
+    struct second_guesses *seconds; // the second guess table, which may be empty
+    struct guess_cache *cache;      // the cache of best guesses, or NULL
+    int *guesses;                   // the number of guesses each game took, or NULL_INDEX if it was given up on
+    double *game_times;             // the wall time of each game in seconds
+    double *search_times;           // the wall time of each find_best_guess call, MAX_BATCH_GUESSES slots per game
+    int *searches;                  // the number of find_best_guess calls of each game
+};
+
+/**
+ * Play a game against a known answer, computing the result of each guess from the feedback matrix.
+ * Each game is its own session, so games can be played on any number of threads at once.
+ * @param index The index of the game in the batch.
+ * @param context The batch to record the game's results in.
+ */
+void play_game(int index, void *context)
+{
+    struct batch *batch = context;
+    struct word_list *list = batch->list;
+    double game_start = get_time();
+    struct session *session = session_new(list, batch->tree, batch->seconds, batch->cache, batch->opener, batch->hard, batch->minimax,
+                                          batch->incremental);
+
+    batch->guesses[index] = NULL_INDEX;
+    batch->searches[index] = 0;
+    while (session->guesses <= MAX_BATCH_GUESSES)
     {
-        printf("RESULT: ");
-        int error_detected = 0; // to detect when an invalid character is found
-        for (int i = 0; i < WORD_SIZE - 1; i++)
+        session_apply_feedback(session, get_outcome(list, session->guess, batch->answers[index]));
+        if (session->solved)
         {
-            char c = to_lower(getchar());
-            if (c == '\n') // skip end line character
-            {
-                i--;
-                continue;
-            }
-
-            if (c == GREEN_INPUT)
-                result[i] = GREEN;
-            else if (c == ORANGE_INPUT)
-                result[i] = ORANGE;
-            else if (c == BLACK_INPUT)
-                result[i] = BLACK;
-            else
-                error_detected = 1; // invalid character was found
+            batch->guesses[index] = session->guesses;
+            break;
         }
-        if (error_detected == 0)
-            return result;                // if input was valid, return the result
-        printf("** invalid result **\n"); // otherwise print error message and retry
+
+        double start = get_time();
+        session_next_guess(session);
+        if (session->searched)
+            batch->search_times[(size_t)index * MAX_BATCH_GUESSES + batch->searches[index]++] = get_time() - start;
     }
+    session_free(session);
+    batch->game_times[index] = get_time() - game_start;
+}
+
+/**
+ * Compare two doubles for qsort.
+ * @param x The first double.
+ * @param y The second double.
+ * @return Negative, zero or positive as x is less than, equal to or greater than y.
+ */
+int compare_doubles(const void *x, const void *y)
+{
+    double a = *(const double *)x, b = *(const double *)y;
+    return (a > b) - (a < b);
 }
 
 /**
- * Find the next best guess.
- * @param guesses The array of all valid guesses.
- * @param answers The array of all valid answers.
- * @param outcomes The array of possible outcomes.
- * @param answer_indexes The array of indexes of the available answers in the current game state.
- * @return The guess that minimises the average amount of answers left.
+ * Get a percentile of some values by the nearest rank method.
+ * @param values The values, which are sorted in place.
+ * @param n The number of values.
+ * @param percent The percentile to get.
+ * @return The percentile, or 0 if there are no values.
  */
-char *find_best_guess(char guesses[GUESSES_LENGTH][WORD_SIZE], char answers[ANSWER_LENGTH][WORD_SIZE], int outcomes[TOTAL_OUTCOMES][WORD_SIZE - 1], int answer_indexes[ANSWER_LENGTH + 1])
+double get_percentile(double *values, int n, int percent)
 {
-    double min_average = ANSWER_LENGTH; // initialise minimum average
-    static char min_word[WORD_SIZE];    // initialise minimum word
+    if (n == 0)
+        return 0;
+    qsort(values, n, sizeof(double), compare_doubles);
+    int rank = (n * percent + 99) / 100; // ceil(n * percent / 100)
+    return values[rank > 0 ? rank - 1 : 0];
+}
+
+/**
+ * Get the indexes of the answers to play a batch against.
+ * @param list The word list, whose guesses start with the answers.
+ * @param file_name The file listing the answers one per line (in any case), or NULL for every answer.
+ * @param indexes The array to store the indexes in, with room for every answer.
+ * @return The number of answers, or NULL_INDEX if the file couldn't be read or has a word that isn't an answer.
+ */
+int get_batch_answers(struct word_list *list, char *file_name, int *indexes)
+{
+    if (file_name == NULL)
+    {
+        for (int i = 0; i < list->answer_count; i++)
+            indexes[i] = i;
+        return list->answer_count;
+    }
+
+    FILE *f = fopen(file_name, "r");
+    if (f == NULL)
+    {
+        printf("** ERROR: could not open %s **\n", file_name);
+        return NULL_INDEX;
+    }
 
-    // check all available answers first
-    int z = 0;
-    while (answer_indexes[z] != NULL_INDEX)
+    int n = 0;
+    char line[BUFSIZ];
+    while (n < list->answer_count && fgets(line, sizeof(line), f) != NULL)
     {
-        int total = TOTAL_OUTCOMES; // initialise total number of valid outcomes
-        int possibles = 0;          // initialise number of possible answers
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0') // skip blank lines
+            continue;
 
-        for (int j = 0; j < TOTAL_OUTCOMES; j++) // for each outcome
+        int index = find_word(list, line);
+        if (index == NULL_INDEX || index >= list->answer_count)
         {
-            int answers_left = 0; // initialise number of answers left for this outcome
-            int k = 0;
-            while (answer_indexes[k] != NULL_INDEX) // for each available answer check if it is possible with the current guess and outcome
-            {
-                if (is_possible(answers[answer_indexes[k]], answers[answer_indexes[z]], outcomes[j]))
-                    answers_left++; // if so add to number of answers left for this outcome
-                k++;
-            }
+            printf("** ERROR: '%s' is not a valid answer **\n", line);
+            fclose(f);
+            return NULL_INDEX;
+        }
+        indexes[n++] = index;
+    }
+    fclose(f);
+    return n;
+}
+
+/**
+ * Print the results of a batch of games.
+ * @param f The file to print to.
+ * @param format The output format, "text", "csv" or "json".
+ * @param opener The first guess used.
+ * @param results The results of the batch, the time arrays are sorted in place.
+ * @param cache The cache of best guesses used.
+ * @param wall_time The wall time of the whole batch in seconds.
+ */
+void print_batch_results(FILE *f, char *format, char *opener, struct batch_results *results, struct guess_cache *cache, double wall_time)
+{
+    int solved = results->games - results->unsolved;
+    int failures = results->unsolved;
+    for (int i = MAX_GUESSES + 1; i <= MAX_BATCH_GUESSES; i++)
+        failures += results->histogram[i];
+    double mean_guesses = solved > 0 ? (double)results->total_guesses / solved : 0;
+    double game_total = 0; // the total latency of the games, which overlap when played on several threads
+    for (int i = 0; i < results->games; i++)
+        game_total += results->game_times[i];
+    double game_mean = results->games > 0 ? game_total / results->games : 0;
+    double games_per_second = wall_time > 0 ? results->games / wall_time : 0;
+    double game_p50 = get_percentile(results->game_times, results->games, 50);
+    double game_p99 = get_percentile(results->game_times, results->games, 99);
+    double search_p50 = get_percentile(results->search_times, results->searches, 50);
+    double search_p99 = get_percentile(results->search_times, results->searches, 99);
+
+    if (strcmp(format, "csv") == 0)
+    {
+        fprintf(f, "opener,games,mean_guesses,failures");
+        for (int i = 1; i <= MAX_GUESSES; i++)
+            fprintf(f, ",guesses_%d", i);
+        fprintf(f, ",wall_seconds,games_per_second,game_ms_mean,game_ms_p50,game_ms_p99,searches,search_ms_p50,search_ms_p99,cache_hits,cache_misses,cache_evictions\n");
+
+        fprintf(f, "%s,%d,%.4lf,%d", opener, results->games, mean_guesses, failures);
+        for (int i = 1; i <= MAX_GUESSES; i++)
+            fprintf(f, ",%d", results->histogram[i]);
+        fprintf(f, ",%.3lf,%.0lf,%.3lf,%.3lf,%.3lf,%d,%.3lf,%.3lf,%ld,%ld,%ld\n", wall_time, games_per_second, game_mean * 1e3, game_p50 * 1e3,
+                game_p99 * 1e3, results->searches, search_p50 * 1e3, search_p99 * 1e3, cache->hits, cache->misses, cache->evictions);
+    }
+    else if (strcmp(format, "json") == 0)
+    {
+        fprintf(f, "{\"opener\": \"%s\", \"games\": %d, \"mean_guesses\": %.4lf, \"failures\": %d, \"histogram\": [", opener, results->games, mean_guesses, failures);
+        for (int i = 1; i <= MAX_GUESSES; i++)
+            fprintf(f, i == 1 ? "%d" : ", %d", results->histogram[i]);
+        fprintf(f, "], \"wall_seconds\": %.3lf, \"games_per_second\": %.0lf, ", wall_time, games_per_second);
+        fprintf(f, "\"game_ms\": {\"mean\": %.3lf, \"p50\": %.3lf, \"p99\": %.3lf}, ", game_mean * 1e3, game_p50 * 1e3, game_p99 * 1e3);
+        fprintf(f, "\"searches\": %d, \"search_ms\": {\"p50\": %.3lf, \"p99\": %.3lf}, ", results->searches, search_p50 * 1e3, search_p99 * 1e3);
+        fprintf(f, "\"cache\": {\"hits\": %ld, \"misses\": %ld, \"evictions\": %ld}}\n", cache->hits, cache->misses, cache->evictions);
+    }
+    else
+    {
+        fprintf(f, "opener: %s\n", opener);
+        fprintf(f, "games: %d\n", results->games);
+        fprintf(f, "mean guesses: %.4lf\n", mean_guesses);
+        fprintf(f, "failures (more than %d guesses): %d\n", MAX_GUESSES, failures);
+        for (int i = 1; i <= MAX_GUESSES; i++)
+            fprintf(f, "  %d guesses: %d\n", i, results->histogram[i]);
+        fprintf(f, "wall time: %.3lfs (%.0lf games/s)\n", wall_time, games_per_second);
+        fprintf(f, "per game: mean %.3lfms, p50 %.3lfms, p99 %.3lfms\n", game_mean * 1e3, game_p50 * 1e3, game_p99 * 1e3);
+        fprintf(f, "per find_best_guess (%d calls): p50 %.3lfms, p99 %.3lfms\n", results->searches, search_p50 * 1e3, search_p99 * 1e3);
+        fprintf(f, "best guess cache: %ld hits, %ld misses, %ld evictions\n", cache->hits, cache->misses, cache->evictions);
+    }
+}
+
+/**
+ * Play the solver against a batch of answers and print how it did.
+ * @param list The word list.
+ * @param opener_index The index of the first guess to play.
+ * @param answers_file The file listing the answers to play against, or NULL for every answer.
+ * @param format The output format, "text", "csv" or "json".
+ * @param output_file The file to print the results to, or NULL for stdout.
+ * @param use_tree Boolean indicating whether to follow the decision tree in TREE_FILE when it covers the opener, and the second
+ * guesses in SECONDS_FILE when they do.
+ * @param hard Boolean indicating whether to play in hard mode.
+ * @param minimax Boolean indicating whether to choose each guess by find_minimax_guess.
+ * @param incremental Boolean indicating whether each game keeps the outcome counts of every guess between searches.
+ * @param cache The cache of best guesses.
+ * @param threads The number of worker threads to play the games on.
+ * @return 0 on success, 1 if the batch couldn't be run.
+ */
+int run_batch(struct word_list *list, int opener_index, char *answers_file, char *format, char *output_file, bool use_tree, bool hard,
+              bool minimax, bool incremental, struct guess_cache *cache, int threads)
+{
+    int *indexes = malloc(sizeof(int) * list->answer_count);
+    int n = get_batch_answers(list, answers_file, indexes);
+    if (n == NULL_INDEX)
+    {
+        free(indexes);
+        return 1;
+    }
+
+    get_feedback_matrix(list); // get the outcome of every guess against every answer
+    struct decision_tree tree = {};
+    struct second_guesses seconds = {};
+    if (use_tree)
+    {
+        load_tree(&tree, TREE_FILE, list);
+        load_second_guesses(&seconds, SECONDS_FILE, list);
+    }
+
+    size_t games = n > 0 ? n : 1;
+    struct batch batch = {list, indexes, opener_index, hard, minimax, incremental, &tree, &seconds, cache, malloc(sizeof(int) * games),
+                          malloc(sizeof(double) * games), malloc(sizeof(double) * games * MAX_BATCH_GUESSES), malloc(sizeof(int) * games)};
+    double start = get_time();
+    parallel_for(n, threads, play_game, &batch, NULL);
+    double wall_time = get_time() - start;
 
-            if (answers_left == 0)     // if we have no answers left for this outcome
-                total--;               // valid outcomes decreases
-            possibles += answers_left; // add to total number of possible answers
+    struct batch_results results = {.games = n, .game_times = batch.game_times, .search_times = batch.search_times};
+    for (int i = 0; i < n; i++)
+    {
+        if (batch.guesses[i] == NULL_INDEX)
+            results.unsolved++;
+        else
+        {
+            results.histogram[batch.guesses[i]]++;
+            results.total_guesses += batch.guesses[i];
         }
+        for (int j = 0; j < batch.searches[i]; j++) // gather the search times of every game at the start
+            results.search_times[results.searches++] = batch.search_times[(size_t)i * MAX_BATCH_GUESSES + j];
+    }
+
+    FILE *f = output_file == NULL ? stdout : fopen(output_file, "w");
+    if (f == NULL)
+        printf("** ERROR: could not open %s **\n", output_file);
+    else
+    {
+        print_batch_results(f, format, get_word(list, opener_index), &results, cache, wall_time);
+        if (f != stdout)
+            fclose(f);
+    }
+
+    free(batch.guesses);
+    free(batch.game_times);
+    free(batch.search_times);
+    free(batch.searches);
+    free_tree(&tree);
+    free_second_guesses(&seconds);
+    free(indexes);
+    return f == NULL;
+}
+
+/**
+ * Compare two ints for qsort.
+ * @param x The first int.
+ * @param y The second int.
+ * @return Negative, zero or positive as x is less than, equal to or greater than y.
+ */
+int compare_ints(const void *x, const void *y)
+{
+    int a = *(const int *)x, b = *(const int *)y;
+    return (a > b) - (a < b);
+}
 
-        double average_words_left = (double)possibles / total; // get the average number of answers left for this guess
-        if (average_words_left == 1)
-            return answers[answer_indexes[z]]; // if average is 1, shortcut and return immediately (can't get better)
+/**
+ * Build the decision tree node of a guess, and every node below it.
+ * @param list The word list and its feedback matrix.
+ * @param tree The tree being built.
+ * @param guess The index of the guess.
+ * @param answer_set The set of answers available when the guess is made.
+ * @param cache The cache of best guesses.
+ * @param search The optimal search to choose guesses by, or NULL to choose them as in solve_word.
+ * @param depth The most guesses each answer may take from this guess on, for the optimal search.
+ * @return The index of the node.
+ */
+int build_tree_node(struct word_list *list, struct decision_tree *tree, int guess, unsigned long long *answer_set, struct guess_cache *cache,
+                    struct optimal_search *search, int depth)
+{
+    int outcomes[count_set(list, answer_set)]; // the outcome of each answer, then each outcome with an edge once, ascending
+    int answers = 0;
+    for (int index = first_in_set(list, answer_set); index != NULL_INDEX; index = next_in_set(list, answer_set, index))
+        outcomes[answers++] = get_outcome(list, guess, index);
+    qsort(outcomes, answers, sizeof(int), compare_ints);
+    int child_count = 0;
+    for (int i = 0; i < answers; i++) // a correct guess ends the game, so has no edge
+    {
+        if ((child_count == 0 || outcomes[i] != outcomes[child_count - 1]) && outcomes[i] != ALL_GREEN(list))
+            outcomes[child_count++] = outcomes[i];
+    }
+
+    int node = add_tree_node(tree, guess, child_count);
+    int edge = tree->nodes[node].first_edge; // read now, as building the children moves the nodes
+    for (int i = 0; i < child_count; i++)
+    {
+        int outcome = outcomes[i];
+        unsigned long long outcome_set[list->set_words]; // the answers left after this outcome, chosen between as in solve_word
+        memcpy(outcome_set, answer_set, sizeof(outcome_set));
+        int next_guess = filter_answers(list, outcome_set, outcome, guess) == 1 ? first_in_set(list, outcome_set)
+                         : search != NULL ? get_optimal_guess(search, outcome_set, depth - 1)
+                                          : find_best_guess(list, outcome_set, NULL, cache, false);
+        int child = build_tree_node(list, tree, next_guess, outcome_set, cache, search, depth - 1);
+        tree->edges[edge++] = (unsigned long long)child << TREE_OUTCOME_BITS | outcome;
+    }
+    return node;
+}
+
+/**
+ * Build the decision tree of every game starting with a first guess, and save it to TREE_FILE.
+ * @param list The word list.
+ * @param opener_index The index of the first guess.
+ * @param cache The cache of best guesses.
+ * @return 0 on success, 1 if the tree couldn't be saved.
+ */
+int run_build_tree(struct word_list *list, int opener_index, struct guess_cache *cache)
+{
+    get_feedback_matrix(list); // get the outcome of every guess against every answer
+    unsigned long long answer_set[list->set_words];
+    fill_set(list, answer_set);
+
+    struct decision_tree tree = {};
+    tree.header.opener = opener_index;
+    build_tree_node(list, &tree, opener_index, answer_set, cache, NULL, MAX_GUESSES);
+
+    bool saved = save_tree(&tree, TREE_FILE, list->checksum);
+    if (saved)
+        printf("** saved the decision tree for %s (%d nodes) to %s **\n", get_word(list, opener_index), tree.header.node_count, TREE_FILE);
+    else
+        printf("** ERROR: could not save %s **\n", TREE_FILE);
+
+    free_tree(&tree);
+    return !saved;
+}
 
-        if (average_words_left < min_average) // otherwise, update min_average, and min_word if out new average is smaller than min_average
+/**
+ * Get the first guesses to build the second guess table for: the best in FIRST_GUESS_FILE, and the opener.
+ * @param list The word list.
+ * @param opener_index The index of the opener, always included.
+ * @param count The number of first guesses to take from FIRST_GUESS_FILE.
+ * @param openers The array to store the index of each first guess in, count + 1 long, left in ascending order.
+ * @return The number of first guesses, or NULL_INDEX if FIRST_GUESS_FILE couldn't be read.
+ */
+int get_seconds_openers(struct word_list *list, int opener_index, int count, int *openers)
+{
+    int n = 0;
+    FILE *f = count > 0 ? fopen(FIRST_GUESS_FILE, "r") : NULL;
+    if (count > 0 && f == NULL)
+    {
+        printf("** ERROR: could not open %s **\n", FIRST_GUESS_FILE);
+        return NULL_INDEX;
+    }
+
+    char line[BUFSIZ], word[BUFSIZ];
+    while (n < count && fgets(line, sizeof(line), f) != NULL)
+    {
+        if (sscanf(line, "%s", word) != 1) // skip blank lines, each line is "word - score"
+            continue;
+        int index = find_word(list, word);
+        if (index == NULL_INDEX)
         {
-            strcpy(min_word, answers[answer_indexes[z]]);
-            min_average = average_words_left;
+            printf("** ERROR: '%s' in %s is not a valid guess **\n", word, FIRST_GUESS_FILE);
+            fclose(f);
+            return NULL_INDEX;
         }
+        openers[n++] = index;
+    }
+    if (f != NULL)
+        fclose(f);
 
-        if (z % 3 == 0)
-            printf("Checking answers.\r"); // print current state of processing
-        else if (z % 3 == 1)
-            printf("Checking answers..\r");
-        else
-            printf("Checking answers...\r");
-        fflush(stdout);
-        z++;
+    openers[n++] = opener_index;
+    qsort(openers, n, sizeof(int), compare_ints);
+    int unique = 1; // the opener may already be one of the best
+    for (int i = 1; i < n; i++)
+    {
+        if (openers[i] != openers[unique - 1])
+            openers[unique++] = openers[i];
     }
+    return unique;
+}
+
+/**
+ * The data shared by every worker building the second guess table.
+ */
+struct seconds_build
+{
+    struct word_list *list; // the word list and its feedback matrix
+    int *openers;           // the index of each first guess
+    int *guesses;           // the second guess of each first guess and outcome
+};
 
-    for (int i = 0; i < GUESSES_LENGTH; i++) // for each guess
+/**
+ * Find the second guess after a first guess and an outcome, the same guess a session would search for.
+ * @param index The first guess (index / outcome_count) and outcome (index % outcome_count).
+ * @param context The table being built.
+ */
+void build_second_guess(int index, void *context)
+{
+    struct seconds_build *build = context;
+    struct word_list *list = build->list;
+    unsigned long long answer_set[list->set_words];
+    fill_set(list, answer_set);
+    int answers_left = keep_outcome(list, build->openers[index / list->outcome_count], index % list->outcome_count, answer_set);
+    build->guesses[index] = answers_left == 0   ? NULL_INDEX
+                            : answers_left == 1 ? first_in_set(list, answer_set)
+                                                : find_best_guess(list, answer_set, NULL, NULL, false);
+}
+
+/**
+ * Build the second guess table of the best first guesses and the opener, and save it to SECONDS_FILE.
+ * @param list The word list.
+ * @param opener_index The index of the opener.
+ * @param count The number of first guesses to take from FIRST_GUESS_FILE.
+ * @param threads The number of worker threads to search on.
+ * @return 0 on success, 1 if the first guesses couldn't be read or the table couldn't be saved.
+ */
+int run_build_seconds(struct word_list *list, int opener_index, int count, int threads)
+{
+    int *openers = malloc(sizeof(int) * (count + 1));
+    int opener_count = get_seconds_openers(list, opener_index, count, openers);
+    if (opener_count == NULL_INDEX)
     {
-        int total = TOTAL_OUTCOMES; // initialise total number of valid outcomes
-        int possibles = 0;          // initialise number of possible answers
+        free(openers);
+        return 1;
+    }
+
+    get_feedback_matrix(list); // get the outcome of every guess against every answer
+    int cells = opener_count * list->outcome_count;
+    struct seconds_build build = {list, openers, malloc(sizeof(int) * cells)};
+    parallel_for(cells, threads, build_second_guess, &build, "Building");
 
-        for (int j = 0; j < TOTAL_OUTCOMES; j++) // for each outcome
+    bool saved = save_second_guesses(SECONDS_FILE, list->checksum, openers, opener_count, list->outcome_count, build.guesses);
+    if (saved)
+        printf("** saved the second guesses of %d first guesses to %s **\n", opener_count, SECONDS_FILE);
+    else
+        printf("** ERROR: could not save %s **\n", SECONDS_FILE);
+
+    free(build.guesses);
+    free(openers);
+    return !saved;
+}
+
+/**
+ * A worst case audit of the solver's strategy from a first guess, shared by every worker.
+ */
+struct audit
+{
+    struct word_list *list;         // the word list and its feedback matrix
+    bool minimax;                   // whether guesses are chosen by find_minimax_guess rather than find_best_guess
+    struct guess_cache *cache;      // the cache of the strategy's guesses, or NULL
+    int opener;                     // the index of the first guess
+    unsigned long long *answer_set; // every answer
+    unsigned long long *guess_set;  // every guess in hard mode, or NULL
+    int *depths;                    // the number of guesses each answer takes, or NULL_INDEX if it was given up on
+};
+
+/**
+ * Choose the next guess as a session of the audited strategy would.
+ * @param audit The audit.
+ * @param answer_set The set of available answers.
+ * @param guess_set The set of legal guesses in hard mode, or NULL.
+ * @param answers_left The number of available answers.
+ * @return The index of the next guess.
+ */
+int choose_audit_guess(struct audit *audit, unsigned long long *answer_set, unsigned long long *guess_set, int answers_left)
+{
+    if (answers_left == 1)
+        return first_in_set(audit->list, answer_set);
+    return audit->minimax ? find_minimax_guess(audit->list, answer_set, guess_set, audit->cache, false)
+                          : find_best_guess(audit->list, answer_set, guess_set, audit->cache, false);
+}
+
+/**
+ * Play every answer that gives an outcome for a guess to the end, recording how many guesses each takes.
+ * Each outcome of the next guess is followed in turn, so every set of answers the strategy can meet is searched once.
+ * @param audit The audit.
+ * @param guess The index of the guess.
+ * @param guesses The number of guesses made, including this one.
+ * @param answer_set The set of answers available when the guess is made.
+ * @param guess_set The set of legal guesses when the guess is made in hard mode, or NULL.
+ * @param outcome The outcome code to follow.
+ */
+void audit_outcome(struct audit *audit, int guess, int guesses, unsigned long long *answer_set, unsigned long long *guess_set, int outcome)
+{
+    struct word_list *list = audit->list;
+    unsigned long long outcome_set[list->set_words]; // the answers left after this outcome
+    memcpy(outcome_set, answer_set, sizeof(outcome_set));
+    int answers_left = filter_answers(list, outcome_set, outcome, guess);
+    if (answers_left == 0)
+        return;
+    if (outcome == ALL_GREEN(list))
+    {
+        audit->depths[guess] = guesses;
+        return;
+    }
+    if (guesses == MAX_BATCH_GUESSES)
+        return; // given up on like a batch game, so its answers stay at NULL_INDEX
+
+    unsigned long long outcome_guesses[guess_set == NULL ? 1 : list->guess_set_words]; // the legal guesses left in hard mode
+    if (guess_set != NULL)
+    {
+        memcpy(outcome_guesses, guess_set, sizeof(outcome_guesses));
+        if (answers_left > 1) // the last answer is always legal, as in a session
+            filter_guesses(list, outcome_guesses, outcome, guess);
+    }
+    unsigned long long *next_guesses = guess_set == NULL ? NULL : outcome_guesses;
+    int next_guess = choose_audit_guess(audit, outcome_set, next_guesses, answers_left);
+
+    // follow the outcome of the first answer not yet followed, then drop its answers, so nothing outcome sized is on the stack
+    unsigned long long remaining[list->set_words]; // the answers whose outcome of the next guess isn't followed yet
+    unsigned long long followed[list->set_words];  // the answers of the outcome just followed
+    memcpy(remaining, outcome_set, sizeof(remaining));
+    for (int index = first_in_set(list, remaining); index != NULL_INDEX; index = first_in_set(list, remaining))
+    {
+        int next_outcome = get_outcome(list, next_guess, index);
+        audit_outcome(audit, next_guess, guesses + 1, outcome_set, next_guesses, next_outcome);
+        memcpy(followed, remaining, sizeof(followed));
+        keep_outcome(list, next_guess, next_outcome, followed);
+        for (int i = 0; i < list->set_words; i++)
+            remaining[i] &= ~followed[i];
+    }
+}
+
+/**
+ * Audit the answers that give an outcome for the first guess, see audit_outcome.
+ * @param index The outcome code.
+ * @param context The audit.
+ */
+void audit_first_outcome(int index, void *context)
+{
+    struct audit *audit = context;
+    audit_outcome(audit, audit->opener, 1, audit->answer_set, audit->guess_set, index);
+}
+
+/**
+ * Play the strategy against an adversary that keeps as many answers as it can, as in Absurdle: each guess gets the outcome
+ * leaving the most answers, the lowest outcome code on ties, so a correct guess only ends the game once it is the last answer.
+ * @param audit The audit.
+ * @param line Set to each guess made, MAX_BATCH_GUESSES long.
+ * @param outcomes Set to the outcome code given for each guess.
+ * @return The number of guesses made, the last being the answer unless the game was given up on after MAX_BATCH_GUESSES.
+ */
+int play_adversary(struct audit *audit, int *line, int *outcomes)
+{
+    struct word_list *list = audit->list;
+    unsigned long long answer_set[list->set_words];
+    unsigned long long guess_set[audit->guess_set == NULL ? 1 : list->guess_set_words];
+    memcpy(answer_set, audit->answer_set, sizeof(answer_set));
+    if (audit->guess_set != NULL)
+        memcpy(guess_set, audit->guess_set, sizeof(guess_set));
+
+    int *answers_left = malloc(sizeof(int) * list->outcome_count); // number of answers left for each outcome
+    int guess = audit->opener;
+    for (int guesses = 1;; guesses++)
+    {
+        memset(answers_left, 0, sizeof(int) * list->outcome_count);
+        for (int index = first_in_set(list, answer_set); index != NULL_INDEX; index = next_in_set(list, answer_set, index))
+            answers_left[get_outcome(list, guess, index)]++;
+        int outcome = 0;
+        for (int i = 1; i < list->outcome_count; i++)
         {
-            int answers_left = 0; // initialise number of answers left for this outcome
-            int k = 0;
-            while (answer_indexes[k] != NULL_INDEX) // for each available answer check if it is possible with the current guess and outcome
-            {
-                if (is_possible(answers[answer_indexes[k]], guesses[i], outcomes[j]))
-                    answers_left++; // if so add to number of answers left for this outcome
-                k++;
-            }
+            if (answers_left[i] > answers_left[outcome])
+                outcome = i;
+        }
 
-            if (answers_left == 0)     // if we have no answers left for this outcome
-                total--;               // valid outcomes decreases
-            possibles += answers_left; // add to total number of possible answers
+        line[guesses - 1] = guess;
+        outcomes[guesses - 1] = outcome;
+        if (outcome == ALL_GREEN(list) || guesses == MAX_BATCH_GUESSES)
+        {
+            free(answers_left);
+            return guesses;
         }
+        filter_answers(list, answer_set, outcome, guess);
+        if (audit->guess_set != NULL && answers_left[outcome] > 1)
+            filter_guesses(list, guess_set, outcome, guess);
+        guess = choose_audit_guess(audit, answer_set, audit->guess_set == NULL ? NULL : guess_set, answers_left[outcome]);
+    }
+}
+
+/**
+ * Audit the worst case of the solver's strategy from a first guess: play every answer to the end at once, following each
+ * outcome of every guess the strategy makes, and play it against an adversary that keeps the most answers each turn.
+ * The outcomes of the first guess are audited over the worker threads.
+ * @param list The word list.
+ * @param opener_index The index of the first guess.
+ * @param format The output format, "text", "csv" or "json".
+ * @param output_file The file to print the results to, or NULL for stdout.
+ * @param hard Boolean indicating whether to play in hard mode.
+ * @param minimax Boolean indicating whether to choose guesses by find_minimax_guess.
+ * @param cache The cache of the strategy's guesses, not used in hard mode.
+ * @param threads The number of worker threads to audit on.
+ * @return 0 on success, 1 if the output file couldn't be opened.
+ */
+int run_audit(struct word_list *list, int opener_index, char *format, char *output_file, bool hard, bool minimax, struct guess_cache *cache,
+              int threads)
+{
+    get_feedback_matrix(list); // get the outcome of every guess against every answer
+    unsigned long long answer_set[list->set_words];
+    unsigned long long guess_set[list->guess_set_words];
+    fill_set(list, answer_set);
+    fill_guess_set(list, guess_set);
+    int *depths = malloc(sizeof(int) * list->answer_count);
+    for (int i = 0; i < list->answer_count; i++)
+        depths[i] = NULL_INDEX;
+    struct audit audit = {list, minimax, cache, opener_index, answer_set, hard ? guess_set : NULL, depths};
 
-        double average_words_left = (double)possibles / total; // get the average number of answers left for this guess
-        if (average_words_left == 1)
-            return guesses[i]; // if average is 1, shortcut and return immediately (can't get better)
+    double start = get_time();
+    parallel_for(list->outcome_count, threads, audit_first_outcome, &audit, NULL);
+    int line[MAX_BATCH_GUESSES], outcomes[MAX_BATCH_GUESSES];
+    int adversary_guesses = play_adversary(&audit, line, outcomes);
+    double wall_time = get_time() - start;
 
-        if (average_words_left < min_average) // otherwise, update min_average, and min_word if out new average is smaller than min_average
+    int histogram[MAX_BATCH_GUESSES + 1] = {};
+    int unsolved = 0, worst_case = 0;
+    long total_guesses = 0;
+    for (int i = 0; i < list->answer_count; i++)
+    {
+        if (depths[i] == NULL_INDEX)
+            unsolved++;
+        else
         {
-            strcpy(min_word, guesses[i]);
-            min_average = average_words_left;
+            histogram[depths[i]]++;
+            total_guesses += depths[i];
+            worst_case = depths[i] > worst_case ? depths[i] : worst_case;
         }
+    }
+    int failures = unsolved;
+    for (int i = MAX_GUESSES + 1; i <= MAX_BATCH_GUESSES; i++)
+        failures += histogram[i];
+    int solved = list->answer_count - unsolved;
+    double mean_guesses = solved > 0 ? (double)total_guesses / solved : 0;
+    int deepest = unsolved > 0 ? NULL_INDEX : worst_case;                 // the depth of the worst case answers
+    int worst_answers = unsolved > 0 ? unsolved : histogram[worst_case]; // the number of worst case answers
+    bool adversary_won = outcomes[adversary_guesses - 1] != ALL_GREEN(list);
+    char *strategy = minimax ? "minimax" : "average";
+    char result[MAX_WORD_LENGTH + 1];
 
-        printf("Checking %d/%d\r", i + 1, GUESSES_LENGTH); // print current state of processing
-        fflush(stdout);                                    // flush stdout for cleaner '\r' printing
+    FILE *f = output_file == NULL ? stdout : fopen(output_file, "w");
+    if (f == NULL)
+        printf("** ERROR: could not open %s **\n", output_file);
+    else if (strcmp(format, "csv") == 0)
+    {
+        fprintf(f, "opener,strategy,hard,answers,worst_case,worst_case_answers,mean_guesses,failures,unsolved");
+        for (int i = 1; i <= MAX_GUESSES; i++)
+            fprintf(f, ",guesses_%d", i);
+        fprintf(f, ",adversary_guesses,adversary_solved,wall_seconds\n");
+        fprintf(f, "%s,%s,%d,%d,%d,%d,%.4lf,%d,%d", get_word(list, opener_index), strategy, hard, list->answer_count, deepest, worst_answers,
+                mean_guesses, failures, unsolved);
+        for (int i = 1; i <= MAX_GUESSES; i++)
+            fprintf(f, ",%d", histogram[i]);
+        fprintf(f, ",%d,%d,%.3lf\n", adversary_guesses, !adversary_won, wall_time);
     }
+    else if (strcmp(format, "json") == 0)
+    {
+        fprintf(f, "{\"opener\": \"%s\", \"strategy\": \"%s\", \"hard\": %s, \"answers\": %d, \"worst_case\": %d, \"mean_guesses\": %.4lf, ",
+                get_word(list, opener_index), strategy, hard ? "true" : "false", list->answer_count, deepest, mean_guesses);
+        fprintf(f, "\"failures\": %d, \"unsolved\": %d, \"histogram\": [", failures, unsolved);
+        for (int i = 1; i <= (worst_case > MAX_GUESSES ? worst_case : MAX_GUESSES); i++)
+            fprintf(f, i == 1 ? "%d" : ", %d", histogram[i]);
+        fprintf(f, "], \"worst_case_answers\": [");
+        for (int i = 0, listed = 0; i < list->answer_count && listed < AUDIT_REPORT_ANSWERS; i++)
+        {
+            if (depths[i] == deepest)
+                fprintf(f, listed++ == 0 ? "\"%s\"" : ", \"%s\"", get_word(list, i));
+        }
+        fprintf(f, "], \"adversary\": [");
+        for (int i = 0; i < adversary_guesses; i++)
+        {
+            format_result(list, outcomes[i], result);
+            fprintf(f, i == 0 ? "[\"%s\", \"%s\"]" : ", [\"%s\", \"%s\"]", get_word(list, line[i]), result);
+        }
+        fprintf(f, "], \"adversary_solved\": %s, \"wall_seconds\": %.3lf}\n", adversary_won ? "false" : "true", wall_time);
+    }
+    else
+    {
+        fprintf(f, "opener: %s\n", get_word(list, opener_index));
+        fprintf(f, "strategy: %s%s\n", strategy, hard ? " (hard mode)" : "");
+        if (unsolved > 0)
+            fprintf(f, "worst case: %d answers given up on after %d guesses\n", unsolved, MAX_BATCH_GUESSES);
+        else
+            fprintf(f, "worst case: %d guesses (%d answers)\n", worst_case, worst_answers);
+        fprintf(f, "mean guesses: %.4lf\n", mean_guesses);
+        fprintf(f, "failures (more than %d guesses): %d\n", MAX_GUESSES, failures);
+        for (int i = 1; i <= (worst_case > MAX_GUESSES ? worst_case : MAX_GUESSES); i++)
+            fprintf(f, "  %d guesses: %d\n", i, histogram[i]);
+        fprintf(f, "worst case answers:");
+        for (int i = 0, listed = 0; i < list->answer_count && listed < AUDIT_REPORT_ANSWERS; i++)
+        {
+            if (depths[i] == deepest)
+                fprintf(f, listed++ == 0 ? " %s" : ", %s", get_word(list, i));
+        }
+        fprintf(f, "%s\nadversary:", worst_answers > AUDIT_REPORT_ANSWERS ? ", ..." : "");
+        for (int i = 0; i < adversary_guesses; i++)
+        {
+            format_result(list, outcomes[i], result);
+            fprintf(f, " %s %s", get_word(list, line[i]), result);
+        }
+        fprintf(f, " (%s in %d guesses)\n", adversary_won ? "given up on" : "solved", adversary_guesses);
+        fprintf(f, "wall time: %.3lfs\n", wall_time);
+    }
+    if (f != NULL && f != stdout)
+        fclose(f);
 
-    return min_word; // return the best word found
+    free(depths);
+    return f == NULL;
 }
 
 /**
- * Filter the currently available answers to account for a new guess and result.
- * @param answers The array of all possible answers.
- * @param answer_indexes The indexes of the currently available answers for the current game state.
- * @param result The result of the new guess.
- * @param guess The new guess.
- * @return The total amount of viable answers left.
+ * Search for the strategy with the fewest expected guesses, print its opener and cost, and save its decision tree to TREE_FILE.
+ * @param list The word list.
+ * @param opener_index The only first guess to search, or NULL_INDEX to search every first guess.
+ * @param depth The most guesses each answer may take.
+ * @param top_k The most guesses tried for each set of answers, 0 to try every guess.
+ * @param threads The number of worker threads searching the first guesses.
+ * @param memo_mb The memo budget, in megabytes.
+ * @return 0 on success, 1 if no strategy solves every answer in time or the tree couldn't be saved.
  */
-int filter_answers(char answers[ANSWER_LENGTH][WORD_SIZE], int answer_indexes[ANSWER_LENGTH + 1], int result[WORD_SIZE - 1], char current_guess[WORD_SIZE])
+int run_optimal(struct word_list *list, int opener_index, int depth, int top_k, int threads, int memo_mb)
 {
-    int new_indexes[ANSWER_LENGTH + 1]; // new indexes array
-    int new_length = 0;
-    int i = 0;
+    get_feedback_matrix(list); // get the outcome of every guess against every answer
+    struct optimal_search search;
+    init_optimal_search(&search, list, top_k, (size_t)memo_mb * BYTES_PER_MB);
 
-    while (answer_indexes[i] != NULL_INDEX) // loop through the currently available answers
+    double start = get_time();
+    int cost;
+    int opener = find_optimal_opener(&search, depth, opener_index, threads, &cost);
+    if (opener == NULL_INDEX)
     {
-        int index = answer_indexes[i];
-        if (is_possible(answers[index], current_guess, result)) // if the answer is still possible add to new indexes array
-            new_indexes[new_length++] = index;
-        i++;
+        printf("** ERROR: no strategy solves every answer in %d guesses **\n", depth);
+        free_optimal_search(&search);
+        return 1;
     }
-    new_indexes[new_length] = NULL_INDEX;
+    printf("** opener: %s - expected guesses: %.4lf (%d over %d answers) - %ld sets searched in %.1lfs, %d memoised **\n",
+           get_word(list, opener), (double)cost / list->answer_count, cost, list->answer_count, atomic_load(&search.sets),
+           get_time() - start, atomic_load(&search.memo.count) < search.memo.capacity ? atomic_load(&search.memo.count) : search.memo.capacity);
+
+    unsigned long long answer_set[list->set_words];
+    fill_set(list, answer_set);
+    struct decision_tree tree = {};
+    tree.header.opener = opener;
+    build_tree_node(list, &tree, opener, answer_set, NULL, &search, depth);
+    free_optimal_search(&search);
+
+    bool saved = save_tree(&tree, TREE_FILE, list->checksum);
+    if (saved)
+        printf("** saved the decision tree for %s (%d nodes) to %s **\n", get_word(list, opener), tree.header.node_count, TREE_FILE);
+    else
+        printf("** ERROR: could not save %s **\n", TREE_FILE);
+
+    free_tree(&tree);
+    return !saved;
+}
+
+/**
+ * A game being played in server mode.
+ */
+struct game_session
+{
+    char id[SESSION_ID_SIZE]; // the id the client gave the game
+    int next;                 // the next session in the same hash bucket, or in the free list
+};
+
+/**
+ * The games being played in server mode, found by id through a chained hash table.
+ */
+struct session_table
+{
+    struct game_session *sessions;
+    char *states;                    // the game state of each session, state_size bytes each
+    size_t state_size;               // the size of a game state, a multiple of its alignment
+    int capacity;                    // the space allocated for sessions
+    int count;                       // the number of sessions ever allocated, used or free
+    int active;                      // the number of sessions in use
+    int free_list;                   // the first unused session, or NULL_INDEX
+    int *buckets;                    // the first session in each hash bucket, or NULL_INDEX
+    int bucket_mask;                 // the number of buckets - 1, the number of buckets is a power of 2
+};
 
-    int j = 0;
-    while (new_indexes[j] != NULL_INDEX) // copy the new indexes array back into answer indexes
+/**
+ * Hash a session id.
+ * @param id The session id.
+ * @return The 64-bit FNV-1a hash of the id.
+ */
+unsigned long long hash_session_id(char *id)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    for (int i = 0; id[i] != '\0'; i++)
     {
-        answer_indexes[j] = new_indexes[j];
-        j++;
+        hash ^= (unsigned char)id[i];
+        hash *= 1099511628211ULL;
     }
-    answer_indexes[j] = NULL_INDEX;
+    return hash;
+}
 
-    return new_length; // return the total number of answers left
+/**
+ * Set up an empty session table.
+ * @param table The table to set up.
+ * @param state_size The size of the game state of a session, get_session_size.
+ */
+void init_sessions(struct session_table *table, size_t state_size)
+{
+    memset(table, 0, sizeof(*table));
+    table->state_size = state_size;
+    table->free_list = NULL_INDEX;
+    table->bucket_mask = SESSION_BUCKETS - 1;
+    table->buckets = malloc(sizeof(int) * (table->bucket_mask + 1));
+    for (int i = 0; i <= table->bucket_mask; i++)
+        table->buckets[i] = NULL_INDEX;
 }
 
 /**
- * Solve for a word.
- * @param total_guesses The total number of guesses so far.
- * @param current_guess The current guess for the word.
- * @param answers The array of all possible answers.
- * @param guesses The array of all possible guesses.
- * @param outcomes The array of all possible outcomes.
- * @param answer_indexes The array of indexes of all currently available answers in the game state.
- * @return The solution, or NULL if an error occurred.
+ * Release a session table.
+ * @param table The table to release.
  */
-char *solve_word(int *total_guesses, char current_guess[WORD_SIZE], char answers[ANSWER_LENGTH][WORD_SIZE], char guesses[GUESSES_LENGTH][WORD_SIZE], int all_outcomes[TOTAL_OUTCOMES][WORD_SIZE - 1], int answer_indexes[ANSWER_LENGTH + 1])
+void free_sessions(struct session_table *table)
 {
-    (*total_guesses)++;         // increment the total guesses
-    int *result = get_result(); // get the result from the current guess
+    free(table->sessions);
+    free(table->states);
+    free(table->buckets);
+    memset(table, 0, sizeof(*table));
+}
+
+/**
+ * Get the game state of a session.
+ * @param table The session table.
+ * @param index The index of the session.
+ * @return The game state.
+ */
+struct session *get_session_state(struct session_table *table, int index)
+{
+    return (struct session *)(table->states + index * table->state_size);
+}
 
-    int answers_left = filter_answers(answers, answer_indexes, result, current_guess); // filter the answers to find how many answers are left
-    if (result[0] == GREEN && result[1] == GREEN && result[2] == GREEN && result[3] == GREEN && result[4] == GREEN)
-    { // if the current guess is correct, return it and decrement total guesses (as we found it before the next guess)
-        (*total_guesses)--;
-        return current_guess;
+/**
+ * Find a session by id.
+ * @param table The session table.
+ * @param id The session id.
+ * @return The index of the session, or NULL_INDEX if there is none.
+ */
+int find_session(struct session_table *table, char *id)
+{
+    for (int i = table->buckets[hash_session_id(id) & table->bucket_mask]; i != NULL_INDEX; i = table->sessions[i].next)
+    {
+        if (strcmp(table->sessions[i].id, id) == 0)
+            return i;
     }
-    else // otherwise print the amount of answers left
-        printf("-- answers left: %d --\n\n", answers_left);
+    return NULL_INDEX;
+}
+
+/**
+ * Add a session to its hash bucket.
+ * @param table The session table.
+ * @param index The index of the session.
+ */
+void link_session(struct session_table *table, int index)
+{
+    int *bucket = &table->buckets[hash_session_id(table->sessions[index].id) & table->bucket_mask];
+    table->sessions[index].next = *bucket;
+    *bucket = index;
+}
+
+/**
+ * Add a session, doubling the buckets once there are more sessions than buckets.
+ * @param table The session table.
+ * @param id The session id, which must not already be in the table.
+ * @return The index of the new session, its game state is not set.
+ */
+int add_session(struct session_table *table, char *id)
+{
+    int index = table->free_list;
+    if (index != NULL_INDEX)
+        table->free_list = table->sessions[index].next;
+    else
+    {
+        if (table->count == table->capacity)
+        {
+            table->capacity = table->capacity > 0 ? table->capacity * 2 : SESSION_BUCKETS;
+            table->sessions = realloc(table->sessions, sizeof(struct game_session) * table->capacity);
+            table->states = realloc(table->states, table->state_size * table->capacity); // a session's state holds no pointers into itself
+        }
+        index = table->count++;
+    }
+    strcpy(table->sessions[index].id, id);
+    link_session(table, index);
+
+    if (++table->active > table->bucket_mask + 1) // rehash every session in use into twice the buckets
+    {
+        table->bucket_mask = table->bucket_mask * 2 + 1;
+        table->buckets = realloc(table->buckets, sizeof(int) * (table->bucket_mask + 1));
+        for (int i = 0; i <= table->bucket_mask; i++)
+            table->buckets[i] = NULL_INDEX;
+        bool *unused = calloc(table->count, sizeof(bool));
+        for (int i = table->free_list; i != NULL_INDEX; i = table->sessions[i].next)
+            unused[i] = true;
+        for (int i = 0; i < table->count; i++)
+        {
+            if (!unused[i])
+                link_session(table, i);
+        }
+        free(unused);
+    }
+    return index;
+}
+
+/**
+ * Remove a session.
+ * @param table The session table.
+ * @param index The index of the session.
+ */
+void remove_session(struct session_table *table, int index)
+{
+    int *link = &table->buckets[hash_session_id(table->sessions[index].id) & table->bucket_mask];
+    while (*link != index)
+        link = &table->sessions[*link].next;
+    *link = table->sessions[index].next;
+
+    table->sessions[index].next = table->free_list;
+    table->free_list = index;
+    table->active--;
+}
+
+/**
+ * Apply the result of a session's last guess and reply with the next guess.
+ * @param list The word list and its feedback matrix.
+ * @param table The session table.
+ * @param index The index of the session.
+ * @param outcome The outcome code of the result.
+ */
+void serve_feedback(struct word_list *list, struct session_table *table, int index, int outcome)
+{
+    struct game_session *game = &table->sessions[index];
+    struct session *session = get_session_state(table, index);
+    int answers_left = session_apply_feedback(session, outcome);
+    if (session->solved) // the game is over, so the session ends
+    {
+        printf("SOLVED %s %s %d\n", game->id, get_word(list, session->guess), session->guesses);
+        remove_session(table, index);
+    }
+    else if (answers_left == 0) // invalid results were given, so the session can't continue
+    {
+        printf("ERROR %s no answers left - invalid result(s)\n", game->id);
+        remove_session(table, index);
+    }
+    else
+        printf("GUESS %s %s\n", game->id, get_word(list, session_next_guess(session)));
+}
+
+/**
+ * Serve games over a line protocol on stdin and stdout, loading the words and feedback matrix once for every game.
+ * Each command is answered with one line:
+ *   NEW id [opener]      -> GUESS id word             start a game, the first guess is the opener
+ *   FEEDBACK id result   -> GUESS id word             the result of the last guess, e.g. gg-o-
+ *                        -> SOLVED id word guesses    when the result is all green, which ends the game
+ *   END id               -> OK id                     abandon a game
+ *   QUIT                                              stop the server
+ * Any invalid command, NEW for a game still being played, or FEEDBACK or END for an unknown id, is answered with ERROR id message.
+ * @param list The word list.
+ * @param opener_index The index of the first guess of games that don't give one.
+ * @param hard Boolean indicating whether every game is played in hard mode.
+ * @param minimax Boolean indicating whether every game chooses its guesses by find_minimax_guess.
+ * @param cache The cache of best guesses shared by every game.
+ * @return 0.
+ */
+int run_server(struct word_list *list, int opener_index, bool hard, bool minimax, struct guess_cache *cache)
+{
+    get_feedback_matrix(list); // get the outcome of every guess against every answer
+    struct decision_tree tree = {};
+    struct second_guesses seconds = {};
+    if (!hard) // the tree and second guesses were found without the hard mode rule
+    {
+        load_tree(&tree, TREE_FILE, list); // followed by games using the opener it was built for
+        load_second_guesses(&seconds, SECONDS_FILE, list);
+    }
+
+    struct session_table table;
+    init_sessions(&table, get_session_size(list, hard, false)); // the counts are too big to keep for many games
+
+    char line[BUFSIZ];
+    while (fgets(line, sizeof(line), stdin) != NULL)
+    {
+        char command[16] = "", id[SESSION_ID_SIZE] = "-", argument[SESSION_ID_SIZE] = "";
+        int fields = sscanf(line, "%15s %63s %63s", command, id, argument);
+        if (fields < 1) // skip blank lines
+            continue;
+
+        int index = fields >= 2 ? find_session(&table, id) : NULL_INDEX;
+        if (strcmp(command, "QUIT") == 0)
+            break;
+        else if (strcmp(command, "NEW") == 0 && fields >= 2)
+        {
+            int opener = fields == 3 ? find_word(list, argument) : opener_index; // the opener is case insensitive
+            if (index != NULL_INDEX) // another client's game, which must be ended first
+                printf("ERROR %s session exists\n", id);
+            else if (opener == NULL_INDEX)
+                printf("ERROR %s invalid opener\n", id);
+            else
+            {
+                index = add_session(&table, id);
+                session_init(get_session_state(&table, index), list, &tree, &seconds, cache, opener, hard, minimax, false);
+                printf("GUESS %s %s\n", id, get_word(list, opener));
+            }
+        }
+        else if (strcmp(command, "FEEDBACK") == 0 && fields == 3)
+        {
+            int outcome = parse_result(list, argument);
+            if (index == NULL_INDEX)
+                printf("ERROR %s unknown session\n", id);
+            else if (outcome == NULL_INDEX)
+                printf("ERROR %s invalid result\n", id);
+            else
+                serve_feedback(list, &table, index, outcome);
+        }
+        else if (strcmp(command, "END") == 0 && fields >= 2)
+        {
+            if (index == NULL_INDEX)
+                printf("ERROR %s unknown session\n", id);
+            else
+            {
+                remove_session(&table, index);
+                printf("OK %s\n", id);
+            }
+        }
+        else
+            printf("ERROR %s invalid command\n", id);
+        fflush(stdout); // reply before waiting for the next command
+    }
+
+    free_sessions(&table);
+    free_tree(&tree);
+    free_second_guesses(&seconds);
+    return 0;
+}
+
+/**
+ * How a logged game ended when replayed.
+ */
+enum replay_status
+{
+    REPLAY_SOLVED,       // the last result was all green
+    REPLAY_UNSOLVED,     // the log stops before an all green result
+    REPLAY_MALFORMED,    // a word isn't a valid guess, a result is missing or invalid, or there are guesses after solving
+    REPLAY_INCONSISTENT, // the results leave no answer
+    REPLAY_STATUSES
+};
+
+/**
+ * The replay of one logged game.
+ */
+struct game_replay
+{
+    enum replay_status status;
+    int guesses;                           // the number of guesses replayed, up to the first problem
+    int matches;                           // the number of guesses that were the solver's pick
+    double luck;                           // the total of the answers the solver's pick leaves on average less those left
+    int answers_left[INGEST_REPORT_GUESSES]; // the answers left after each of the first guesses
+};
+
+/**
+ * The data shared by every worker replaying a block of logged games.
+ */
+struct ingest
+{
+    struct word_list *list;         // the word list and its feedback matrix
+    struct guess_cache *cache;      // the cache of best guesses, or NULL
+    struct second_guesses *seconds; // the second guess table, which may be empty
+    bool picks;                     // whether each guess is compared with the solver's pick
+    int first_pick;                 // the solver's first guess, the same for every game
+    double first_expected;          // the answers the solver's first guess leaves on average
+    char *buffer;                   // the block of the log read, each game line terminated in place
+    int *lines;                     // the offset in buffer of each game line
+    struct game_replay *replays;    // the replay of each game line
+};
+
+/**
+ * The totals of every replayed game.
+ */
+struct ingest_results
+{
+    bool picks;                                 // whether the guesses were compared with the solver's picks
+    long games;                                 // the number of games in the log
+    long statuses[REPLAY_STATUSES];             // the number of games ending each way
+    long histogram[MAX_BATCH_GUESSES + 1];      // the number of games solved in each number of guesses
+    long total_guesses;                         // the total guesses over every game, up to the first problem
+    long matches;                               // the number of guesses that were the solver's pick
+    double luck;                                // the total luck over every guess
+    long reached[INGEST_REPORT_GUESSES];        // the number of games reaching each guess
+    double answers_left[INGEST_REPORT_GUESSES]; // the total answers left after each guess over the games reaching it
+};
 
-    if (answers_left == 0) // if we have no answers left, an error has occured so return null
+/**
+ * Get the next token of a game line, separated by spaces or tabs, terminating it in place.
+ * @param cursor Where to start looking, moved past the token.
+ * @return The token, or NULL at the end of the line.
+ */
+char *next_log_token(char **cursor)
+{
+    char *token = *cursor + strspn(*cursor, " \t\r");
+    if (*token == '\0')
         return NULL;
-    else if (answers_left == 1) // if we have one answer left, return it
-        return answers[answer_indexes[0]];
+    char *end = token + strcspn(token, " \t\r");
+    *cursor = *end == '\0' ? end : end + 1;
+    *end = '\0';
+    return token;
+}
+
+/**
+ * Replay a logged game, a guess and its result after another, against the solver's pick at each turn.
+ * @param index The index of the game line in the block.
+ * @param context The ingest to read the line from and record the replay in.
+ */
+void replay_game(int index, void *context)
+{
+    struct ingest *ingest = context;
+    struct word_list *list = ingest->list;
+    struct game_replay *replay = &ingest->replays[index];
+    *replay = (struct game_replay){.status = REPLAY_UNSOLVED};
+
+    unsigned long long answer_set[list->set_words];
+    fill_set(list, answer_set);
+    int answers_left = list->answer_count;
+    int second = NULL_INDEX; // the solver's second guess after the player's first, from the table
+    char *cursor = ingest->buffer + ingest->lines[index];
+    for (char *word; (word = next_log_token(&cursor)) != NULL;)
+    {
+        char *result = next_log_token(&cursor);
+        int guess = find_word(list, word);
+        int outcome = result == NULL ? NULL_INDEX : parse_result(list, result);
+        if (guess == NULL_INDEX || outcome == NULL_INDEX || replay->status == REPLAY_SOLVED || replay->guesses == MAX_BATCH_GUESSES)
+        {
+            replay->status = REPLAY_MALFORMED;
+            return;
+        }
+
+        int best = NULL_INDEX;
+        double expected = 0; // the answers the solver's pick leaves on average
+        if (ingest->picks && replay->guesses == 0)
+        {
+            best = ingest->first_pick;
+            expected = ingest->first_expected;
+        }
+        else if (ingest->picks)
+        {
+            best = second != NULL_INDEX ? second
+                   : answers_left == 1  ? first_in_set(list, answer_set)
+                                        : find_best_guess(list, answer_set, NULL, ingest->cache, false);
+            expected = score_guess(list, best, answer_set);
+        }
+        second = replay->guesses == 0 && ingest->picks ? get_second_guess(ingest->seconds, guess, outcome) : NULL_INDEX;
+        answers_left = filter_answers(list, answer_set, outcome, guess);
+        if (answers_left == 0) // also an all green result for a guess that isn't an answer left
+        {
+            replay->status = REPLAY_INCONSISTENT;
+            return;
+        }
 
-    char *next_best = find_best_guess(guesses, answers, all_outcomes, answer_indexes);           // otherwise find the next best guess
-    printf(" GUESS: %s         \n", next_best);                                                  // print it out
-    return solve_word(total_guesses, next_best, answers, guesses, all_outcomes, answer_indexes); // keep solving
+        replay->matches += guess == best;
+        replay->luck += ingest->picks ? expected - answers_left : 0;
+        if (replay->guesses < INGEST_REPORT_GUESSES)
+            replay->answers_left[replay->guesses] = answers_left;
+        replay->guesses++;
+        if (outcome == ALL_GREEN(list))
+            replay->status = REPLAY_SOLVED;
+    }
 }
 
-int main()
+/**
+ * Add the replays of a block of games to the totals.
+ * @param results The totals.
+ * @param replays The replay of each game.
+ * @param games The number of games.
+ */
+void add_replays(struct ingest_results *results, struct game_replay *replays, int games)
 {
-    char answers[ANSWER_LENGTH][WORD_SIZE];
-    char guesses[GUESSES_LENGTH][WORD_SIZE];
-    get_answers_guesses(answers, guesses); // get answers and guesses
+    for (int i = 0; i < games; i++)
+    {
+        struct game_replay *replay = &replays[i];
+        results->games++;
+        results->statuses[replay->status]++;
+        if (replay->status == REPLAY_SOLVED)
+            results->histogram[replay->guesses]++;
+        results->total_guesses += replay->guesses;
+        results->matches += replay->matches;
+        results->luck += replay->luck;
+        for (int j = 0; j < replay->guesses && j < INGEST_REPORT_GUESSES; j++)
+        {
+            results->reached[j]++;
+            results->answers_left[j] += replay->answers_left[j];
+        }
+    }
+}
 
-    char *first_guess = get_first_guess(guesses); // get the first guess
+/**
+ * Print the totals of the replayed games.
+ * @param f The file to print to.
+ * @param format The output format, "text", "csv" or "json".
+ * @param results The totals.
+ * @param cache The cache of best guesses used.
+ * @param wall_time The wall time of the whole log in seconds.
+ */
+void print_ingest_results(FILE *f, char *format, struct ingest_results *results, struct guess_cache *cache, double wall_time)
+{
+    const char *status_names[REPLAY_STATUSES] = {"solved", "unsolved", "malformed", "inconsistent"};
+    long solved = results->statuses[REPLAY_SOLVED], solved_guesses = 0, failures = 0;
+    for (int i = 1; i <= MAX_BATCH_GUESSES; i++)
+    {
+        solved_guesses += (long)i * results->histogram[i];
+        failures += i > MAX_GUESSES ? results->histogram[i] : 0;
+    }
+    double mean_guesses = solved > 0 ? (double)solved_guesses / solved : 0;
+    double match_rate = results->total_guesses > 0 ? (double)results->matches / results->total_guesses : 0;
+    double mean_luck = results->total_guesses > 0 ? results->luck / results->total_guesses : 0;
+    double games_per_second = wall_time > 0 ? results->games / wall_time : 0;
 
-    int all_outcomes[TOTAL_OUTCOMES][WORD_SIZE - 1];
-    get_all_possible_outcomes(all_outcomes); // get all outcomes
+    if (strcmp(format, "csv") == 0)
+    {
+        fprintf(f, "games");
+        for (int i = 0; i < REPLAY_STATUSES; i++)
+            fprintf(f, ",%s", status_names[i]);
+        fprintf(f, ",mean_guesses,failures");
+        for (int i = 1; i <= MAX_GUESSES; i++)
+            fprintf(f, ",guesses_%d", i);
+        fprintf(f, ",guesses_replayed,pick_rate,mean_luck");
+        for (int i = 1; i <= INGEST_REPORT_GUESSES; i++)
+            fprintf(f, ",answers_left_%d", i);
+        fprintf(f, ",wall_seconds,games_per_second,cache_hits,cache_misses,cache_evictions\n");
 
-    int answer_indexes[ANSWER_LENGTH + 1]; // initialise answer indexes that stores the indexes of all currently available answers
-    for (int i = 0; i < ANSWER_LENGTH; i++)
-        answer_indexes[i] = i;
-    answer_indexes[ANSWER_LENGTH] = NULL_INDEX;
+        fprintf(f, "%ld", results->games);
+        for (int i = 0; i < REPLAY_STATUSES; i++)
+            fprintf(f, ",%ld", results->statuses[i]);
+        fprintf(f, ",%.4lf,%ld", mean_guesses, failures);
+        for (int i = 1; i <= MAX_GUESSES; i++)
+            fprintf(f, ",%ld", results->histogram[i]);
+        fprintf(f, ",%ld", results->total_guesses);
+        fprintf(f, results->picks ? ",%.4lf,%.4lf" : ",,", match_rate, mean_luck); // left empty without the picks
+        for (int i = 0; i < INGEST_REPORT_GUESSES; i++)
+            fprintf(f, ",%.4lf", results->reached[i] > 0 ? results->answers_left[i] / results->reached[i] : 0);
+        fprintf(f, ",%.3lf,%.0lf,%ld,%ld,%ld\n", wall_time, games_per_second, cache->hits, cache->misses, cache->evictions);
+    }
+    else if (strcmp(format, "json") == 0)
+    {
+        fprintf(f, "{\"games\": %ld", results->games);
+        for (int i = 0; i < REPLAY_STATUSES; i++)
+            fprintf(f, ", \"%s\": %ld", status_names[i], results->statuses[i]);
+        fprintf(f, ", \"mean_guesses\": %.4lf, \"failures\": %ld, \"histogram\": [", mean_guesses, failures);
+        for (int i = 1; i <= MAX_GUESSES; i++)
+            fprintf(f, i == 1 ? "%ld" : ", %ld", results->histogram[i]);
+        fprintf(f, "], \"guesses_replayed\": %ld, ", results->total_guesses);
+        fprintf(f, results->picks ? "\"pick_rate\": %.4lf, \"mean_luck\": %.4lf, " : "\"pick_rate\": null, \"mean_luck\": null, ", match_rate, mean_luck);
+        fprintf(f, "\"answers_left\": [");
+        for (int i = 0; i < INGEST_REPORT_GUESSES; i++)
+            fprintf(f, i == 0 ? "%.4lf" : ", %.4lf", results->reached[i] > 0 ? results->answers_left[i] / results->reached[i] : 0);
+        fprintf(f, "], \"wall_seconds\": %.3lf, \"games_per_second\": %.0lf, ", wall_time, games_per_second);
+        fprintf(f, "\"cache\": {\"hits\": %ld, \"misses\": %ld, \"evictions\": %ld}}\n", cache->hits, cache->misses, cache->evictions);
+    }
+    else
+    {
+        fprintf(f, "games: %ld\n", results->games);
+        for (int i = 0; i < REPLAY_STATUSES; i++)
+            fprintf(f, "  %s: %ld\n", status_names[i], results->statuses[i]);
+        fprintf(f, "mean guesses (solved games): %.4lf\n", mean_guesses);
+        fprintf(f, "failures (solved in more than %d guesses): %ld\n", MAX_GUESSES, failures);
+        for (int i = 1; i <= MAX_GUESSES; i++)
+            fprintf(f, "  %d guesses: %ld\n", i, results->histogram[i]);
+        fprintf(f, "guesses replayed: %ld\n", results->total_guesses);
+        if (results->picks)
+        {
+            fprintf(f, "the solver's pick: %.2lf%% of guesses\n", match_rate * 100);
+            fprintf(f, "mean luck per guess: %+.4lf answers (left on average by the solver's pick, less those actually left)\n", mean_luck);
+        }
+        fprintf(f, "mean answers left after each guess:");
+        for (int i = 0; i < INGEST_REPORT_GUESSES && results->reached[i] > 0; i++)
+            fprintf(f, " %.2lf", results->answers_left[i] / results->reached[i]);
+        fprintf(f, "\nwall time: %.3lfs, %.0lf games/s\n", wall_time, games_per_second);
+        fprintf(f, "best guess cache: %ld hits, %ld misses, %ld evictions\n", cache->hits, cache->misses, cache->evictions);
+    }
+}
 
-    int total_guesses = 1;                                                                                    // we've had one guess already
-    char *solution = solve_word(&total_guesses, first_guess, answers, guesses, all_outcomes, answer_indexes); // solve for the word
+/**
+ * Replay a log of games and print how the players did against the solver.
+ * The log is streamed through a fixed buffer: each block of whole lines read is split and terminated in place, its games
+ * replayed over the worker threads, and its unfinished last line moved to the front for the next read.
+ * @param list The word list.
+ * @param log_file The log, a game per line of guesses each followed by its result (e.g. "trace -o--- sound ggggg"), or "-" for stdin.
+ * @param format The output format, "text", "csv" or "json".
+ * @param output_file The file to print the results to, or NULL for stdout.
+ * @param picks Boolean indicating whether to compare each guess with the solver's pick, the slowest part by far.
+ * @param cache The cache of best guesses, shared by every game.
+ * @param threads The number of worker threads to replay the games on.
+ * @return 0 on success, 1 if the log couldn't be read.
+ */
+int run_ingest(struct word_list *list, char *log_file, char *format, char *output_file, bool picks, struct guess_cache *cache, int threads)
+{
+    FILE *log = strcmp(log_file, "-") == 0 ? stdin : fopen(log_file, "rb");
+    if (log == NULL)
+    {
+        printf("** ERROR: could not open %s **\n", log_file);
+        return 1;
+    }
 
-    if (solution == NULL) // if invalid results were inputted that lead to no answers left
+    get_feedback_matrix(list); // get the outcome of every guess against every answer
+    char *buffer = malloc(INGEST_BUFFER_BYTES + 1); // room to terminate a last line without a line ending
+    int *lines = malloc(sizeof(int) * INGEST_BLOCK_GAMES);
+    struct game_replay *replays = malloc(sizeof(struct game_replay) * INGEST_BLOCK_GAMES);
+    struct second_guesses seconds = {};
+    if (picks)
+        load_second_guesses(&seconds, SECONDS_FILE, list); // turn two is a lookup after the first guesses it has
+    struct ingest ingest = {list, cache, &seconds, picks, NULL_INDEX, 0, buffer, lines, replays};
+    struct ingest_results results = {.picks = picks};
+    size_t filled = 0;
+    bool ended = false, too_long = false;
+    double start = get_time();
+    if (picks) // every game starts from every answer, so its first pick is only found once
+    {
+        unsigned long long answer_set[list->set_words];
+        fill_set(list, answer_set);
+        ingest.first_pick = find_best_guess(list, answer_set, NULL, cache, false);
+        ingest.first_expected = score_guess(list, ingest.first_pick, answer_set);
+    }
+    while (!ended || filled > 0)
     {
-        printf("** ERROR: no answers left - invalid result(s) **\n");
+        if (!ended)
+        {
+            size_t wanted = INGEST_BUFFER_BYTES - filled;
+            size_t read = fread(buffer + filled, 1, wanted, log);
+            filled += read;
+            ended = read < wanted; // the end of the log, or an error
+        }
+
+        size_t used = 0; // the bytes of whole lines split off
+        int games = 0;
+        while (games < INGEST_BLOCK_GAMES && used < filled)
+        {
+            char *end = memchr(buffer + used, '\n', filled - used);
+            if (end == NULL && !ended)
+                break; // the rest of the line is still to be read
+            if (end == NULL)
+                end = buffer + filled;
+            *end = '\0';
+            if (buffer[used + strspn(buffer + used, " \t\r")] != '\0') // skip blank lines
+                lines[games++] = used;
+            used = (size_t)(end - buffer) + 1 < filled ? (size_t)(end - buffer) + 1 : filled;
+        }
+        if (used == 0 && filled == INGEST_BUFFER_BYTES)
+        {
+            too_long = true;
+            break;
+        }
+
+        parallel_for(games, threads, replay_game, &ingest, NULL);
+        add_replays(&results, replays, games);
+        memmove(buffer, buffer + used, filled - used);
+        filled -= used;
+    }
+    double wall_time = get_time() - start;
+    if (log != stdin)
+        fclose(log);
+
+    FILE *f = NULL;
+    if (too_long)
+        printf("** ERROR: a line of %s is longer than %d bytes **\n", log_file, INGEST_BUFFER_BYTES);
+    else if ((f = output_file == NULL ? stdout : fopen(output_file, "w")) == NULL)
+        printf("** ERROR: could not open %s **\n", output_file);
+    else
+    {
+        print_ingest_results(f, format, &results, cache, wall_time);
+        if (f != stdout)
+            fclose(f);
+    }
+
+    free(buffer);
+    free(lines);
+    free(replays);
+    free_second_guesses(&seconds);
+    return f == NULL;
+}
+
+/**
+ * Find the first guess given on the command line.
+ * @param list The word list.
+ * @param opener The first guess, in any case.
+ * @return The index of the first guess, or NULL_INDEX if it isn't a valid guess.
+ */
+int get_opener_index(struct word_list *list, char *opener)
+{
+    int index = find_word(list, opener); // the opener is case insensitive, like the interactive first guess
+    if (index == NULL_INDEX)
+        printf("** ERROR: '%s' is not a valid guess **\n", opener);
+    return index;
+}
+
+/**
+ * Print how to run the program.
+ * @param program The name of the program.
+ */
+void print_usage(char *program)
+{
+    printf("usage: %s [--hard] [--minimax | --incremental] [--profile] [--batch [--opener WORD] [--answers FILE] [--format text|csv|json] [--output FILE] [--tree] [--threads N]] [word options] [cache options]\n", program);
+    printf("       %s --build-tree [--opener WORD] [word options] [cache options]\n", program);
+    printf("       %s --build-seconds N [--opener WORD] [--threads N] [word options]\n", program);
+    printf("       %s --worst-case [--hard] [--minimax] [--opener WORD] [--format text|csv|json] [--output FILE] [--threads N] [word options] [cache options]\n", program);
+    printf("       %s --serve [--hard] [--minimax] [--opener WORD] [word options] [cache options]\n", program);
+    printf("       %s --boards N [--threads N] [word options]\n", program);
+    printf("       %s --ingest FILE [--no-picks] [--format text|csv|json] [--output FILE] [--threads N] [word options] [cache options]\n", program);
+    printf("       %s --optimal [--opener WORD] [--top-k K] [--depth N] [--threads N] [--cache-size MB] [word options]\n", program);
+    printf("  with no options, solve one game interactively (following %s when it was built for the first guess, and %s\n", TREE_FILE,
+           SECONDS_FILE);
+    printf("  when it has the first guess)\n");
+    printf("  --batch          play the solver against every answer (or those in --answers) and report how it did\n");
+    printf("  --build-tree     precompute every guess the solver makes after --opener and save them to %s\n", TREE_FILE);
+    printf("  --build-seconds N  find the second guess after every result of the best N first guesses in %s and --opener, and\n",
+           FIRST_GUESS_FILE);
+    printf("                   save them to %s, which turn two looks up instead of searching\n", SECONDS_FILE);
+    printf("  --worst-case     play every answer from --opener at once, following every result of each guess, and report the most\n");
+    printf("                   guesses any answer takes, and the game against an adversary giving the result that leaves the most answers\n");
+    printf("  --serve          serve many games over a line protocol on stdin and stdout (NEW id [opener], FEEDBACK id result, END id, QUIT)\n");
+    printf("  --opener WORD    the first guess in batch mode, for --build-tree, --worst-case and for served games (default: %s)\n",
+           DEFAULT_OPENER);
+    printf("  --answers FILE   the answers to play against in batch mode, one per line\n");
+    printf("  --format FORMAT  the batch, ingest or worst case report format: text (default), csv or json\n");
+    printf("  --output FILE    write the report to FILE instead of stdout\n");
+    printf("  --tree           follow %s in batch mode when it was built for the opener, and look up %s when it has the opener\n",
+           TREE_FILE, SECONDS_FILE);
+    printf("  --ingest FILE    replay a log of games (or - for stdin), a line of guesses each followed by its result, against the\n");
+    printf("                   solver's pick at each turn, and report the answers left, luck and invalid games (cache default: %dMB)\n",
+           DEFAULT_CACHE_MB);
+    printf("  --no-picks       replay the log without finding the solver's picks, leaving out the luck, many times faster\n");
+    printf("  --boards N       solve N boards at once interactively (e.g. 4 for Quordle, 8 for Octordle), a result per board each turn\n");
+    printf("  --threads N      play batch games, replay logged games, build second guesses, audit the first results, score guesses\n");
+    printf("                   across the boards or search first guesses over N worker threads (default: number of processors)\n");
+    printf("  --optimal        search for the strategy with the fewest expected guesses, and save its decision tree to %s\n", TREE_FILE);
+    printf("                   (from --opener if given, otherwise the best first guess; --cache-size is the memo budget, default %dMB)\n",
+           DEFAULT_MEMO_MB);
+    printf("  --top-k K        try only the K most promising guesses for each set of answers, 0 for every guess (exact, default: %d)\n",
+           DEFAULT_TOP_K);
+    printf("  --depth N        the most guesses any answer may take in the optimal search (default: %d)\n", MAX_GUESSES);
+    printf("  --profile        print counters and timings of the search, filtering and each turn on exit (to stderr with --serve)\n");
+    printf("  --hard           play in hard mode, only guessing words consistent with every earlier result (%s, %s and the cache\n",
+           TREE_FILE, SECONDS_FILE);
+    printf("                   aren't used)\n");
+    printf("  --minimax        choose each guess to leave the fewest answers for its worst result, rather than on average\n");
+    printf("                   (%s, %s and --cache-file aren't used)\n", TREE_FILE, SECONDS_FILE);
+    printf("  --incremental    keep how many answers give each outcome for every guess between searches, updated by the answers each\n");
+    printf("                   result eliminates, instead of searching from scratch (2 bytes per guess and outcome, a game)\n");
+    printf("word options:\n");
+    printf("  --answer-list FILE  the answers, one per line (default: %s)\n", ANSWERS_FILE);
+    printf("  --guess-list FILE   the guesses that aren't answers, one per line (default: %s)\n", GUESSES_FILE);
+    printf("  --dictionary FILE   the packed dictionary, used instead of the lists when it is newer (default: %s, or only FILE if\n", DICTIONARY_FILE);
+    printf("                      no list is given, and none if a list is given without it)\n");
+    printf("cache options:\n");
+    printf("  --cache-size MB  remember the best guess for up to MB megabytes of game states (default: off, %dMB with --serve)\n", DEFAULT_CACHE_MB);
+    printf("  --cache-file FILE  load the remembered best guesses from FILE, and save them back on exit (default size: %dMB)\n", DEFAULT_CACHE_MB);
+}
+
+int main(int argc, char *argv[])
+{
+    bool batch = false, build_tree = false, use_tree = false, serve = false, hard = false, incremental = false, optimal = false, opener_given = false;
+    bool picks = true, minimax = false, worst_case = false;
+    char *opener = DEFAULT_OPENER, *answers_file = NULL, *format = "text", *output_file = NULL, *cache_file = NULL, *log_file = NULL;
+    char *answer_list = NULL, *guess_list = NULL, *dictionary = NULL;
+    int cache_mb = NULL_INDEX; // NULL_INDEX until given
+    int boards = 1, threads = get_thread_count(), top_k = DEFAULT_TOP_K, depth = MAX_GUESSES;
+    int seconds_count = NULL_INDEX; // the best first guesses to build the second guess table for, NULL_INDEX unless building it
+    for (int i = 1; i < argc; i++)
+    {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--batch") == 0)
+            batch = true;
+        else if (strcmp(argv[i], "--build-tree") == 0)
+            build_tree = true;
+        else if (strcmp(argv[i], "--build-seconds") == 0 && has_value && atoi(argv[i + 1]) >= 0)
+            seconds_count = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--tree") == 0)
+            use_tree = true;
+        else if (strcmp(argv[i], "--serve") == 0)
+            serve = true;
+        else if (strcmp(argv[i], "--hard") == 0)
+            hard = true;
+        else if (strcmp(argv[i], "--incremental") == 0)
+            incremental = true;
+        else if (strcmp(argv[i], "--minimax") == 0)
+            minimax = true;
+        else if (strcmp(argv[i], "--worst-case") == 0)
+            worst_case = true;
+        else if (strcmp(argv[i], "--optimal") == 0)
+            optimal = true;
+        else if (strcmp(argv[i], "--profile") == 0)
+            profiling = true;
+        else if (strcmp(argv[i], "--top-k") == 0 && has_value && atoi(argv[i + 1]) >= 0)
+            top_k = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--depth") == 0 && has_value && atoi(argv[i + 1]) > 0)
+            depth = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--boards") == 0 && has_value && atoi(argv[i + 1]) >= 1 && atoi(argv[i + 1]) <= MAX_BOARDS)
+            boards = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && has_value && atoi(argv[i + 1]) > 0)
+            threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--opener") == 0 && has_value)
+        {
+            opener = argv[++i];
+            opener_given = true;
+        }
+        else if (strcmp(argv[i], "--ingest") == 0 && has_value)
+            log_file = argv[++i];
+        else if (strcmp(argv[i], "--no-picks") == 0)
+            picks = false;
+        else if (strcmp(argv[i], "--answers") == 0 && has_value)
+            answers_file = argv[++i];
+        else if (strcmp(argv[i], "--format") == 0 && has_value &&
+                 (strcmp(argv[i + 1], "text") == 0 || strcmp(argv[i + 1], "csv") == 0 || strcmp(argv[i + 1], "json") == 0))
+            format = argv[++i];
+        else if (strcmp(argv[i], "--output") == 0 && has_value)
+            output_file = argv[++i];
+        else if (strcmp(argv[i], "--answer-list") == 0 && has_value)
+            answer_list = argv[++i];
+        else if (strcmp(argv[i], "--guess-list") == 0 && has_value)
+            guess_list = argv[++i];
+        else if (strcmp(argv[i], "--dictionary") == 0 && has_value)
+            dictionary = argv[++i];
+        else if (strcmp(argv[i], "--cache-size") == 0 && has_value && atoi(argv[i + 1]) >= 0)
+            cache_mb = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--cache-file") == 0 && has_value)
+            cache_file = argv[++i];
+        else
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    bool build_seconds = seconds_count != NULL_INDEX;
+    if ((hard && (build_tree || use_tree || build_seconds)) || // decision trees and second guesses are found without the hard mode rule
+        (build_seconds && (batch || build_tree || serve || incremental || optimal || boards > 1 || log_file != NULL)) ||
+        (boards > 1 && (hard || batch || build_tree || serve)) || // several boards are only solved interactively
+        (optimal && (hard || batch || build_tree || serve || boards > 1)) ||
+        (incremental && (build_tree || serve || optimal || boards > 1)) || // the counts are too big to keep for every served game
+        (log_file != NULL && (hard || incremental || batch || build_tree || serve || optimal || boards > 1)) ||
+        (minimax && (use_tree || build_tree || build_seconds || optimal || incremental || boards > 1 || log_file != NULL)) || // average case only
+        (minimax && cache_file != NULL) || // a cache file holds best guesses
+        (worst_case && (batch || build_tree || build_seconds || serve || optimal || incremental || boards > 1 || log_file != NULL)))
+    {
+        print_usage(argv[0]);
         return 1;
     }
-    printf("** ANSWER: %s - Guesses: %d **\n\n", solution, total_guesses); // print the summary of the solution
-    return 0;
+
+    choose_word_files(&answer_list, &guess_list, &dictionary);
+    struct word_list list;
+    if (!load_word_list(&list, answer_list, guess_list, dictionary)) // get answers and guesses, and index them to validate the words given
+        return 1;
+
+    int memo_mb = DEFAULT_MEMO_MB;
+    if (optimal && cache_mb != NULL_INDEX) // the optimal search memoises its own sets instead of using the cache
+    {
+        memo_mb = cache_mb;
+        cache_mb = 0;
+    }
+    struct guess_cache cache;
+    if (cache_mb == NULL_INDEX)
+        cache_mb = cache_file == NULL && !serve && log_file == NULL ? 0 : DEFAULT_CACHE_MB;
+    init_cache(&cache, &list, (size_t)cache_mb * BYTES_PER_MB);
+    if (cache_file != NULL)
+        load_cache(&cache, cache_file);
+
+    int status = 0;
+    if (log_file != NULL)
+        status = run_ingest(&list, log_file, format, output_file, picks, &cache, threads);
+    else if (optimal)
+    {
+        int opener_index = opener_given ? get_opener_index(&list, opener) : NULL_INDEX;
+        status = opener_given && opener_index == NULL_INDEX ? 1 : run_optimal(&list, opener_index, depth, top_k, threads, memo_mb);
+    }
+    else if (batch || build_tree || serve || build_seconds || worst_case)
+    {
+        int opener_index = get_opener_index(&list, opener);
+        if (opener_index == NULL_INDEX)
+            status = 1;
+        else if (serve)
+            status = run_server(&list, opener_index, hard, minimax, &cache);
+        else if (build_tree)
+            status = run_build_tree(&list, opener_index, &cache);
+        else if (build_seconds)
+            status = run_build_seconds(&list, opener_index, seconds_count, threads);
+        else if (worst_case)
+            status = run_audit(&list, opener_index, format, output_file, hard, minimax, &cache, threads);
+        else
+            status = run_batch(&list, opener_index, answers_file, format, output_file, use_tree, hard, minimax, incremental, &cache,
+                               threads);
+    }
+    else
+    {
+        int first_guess = get_first_guess(&list); // get the first guess
+        if (first_guess == NULL_INDEX)             // the input ended before the game started
+            status = 1;
+        else if (boards > 1)
+        {
+            get_feedback_matrix(&list); // get the outcome of every guess against every answer
+            status = solve_boards(&list, boards, first_guess, threads);
+        }
+        else
+        {
+            get_feedback_matrix(&list); // get the outcome of every guess against every answer
+            struct decision_tree tree = {};
+            struct second_guesses seconds = {};
+            if (!hard)
+            {
+                load_tree(&tree, TREE_FILE, &list); // the tree is only followed if it was built for this first guess
+                load_second_guesses(&seconds, SECONDS_FILE, &list); // and the table if it has this first guess
+            }
+
+            struct session *session = session_new(&list, &tree, &seconds, &cache, first_guess, hard, minimax, incremental); // one guess already
+            session->show_progress = true;
+            char *solution = solve_word(session); // solve for the word
+
+            if (solution == NULL) // if invalid results were inputted that lead to no answers left
+            {
+                printf("** ERROR: no answers left - invalid result(s) **\n");
+                status = 1;
+            }
+            else
+                printf("** ANSWER: %s - Guesses: %d **\n\n", solution, session->guesses); // print the summary of the solution
+            session_free(session);
+            free_tree(&tree);
+            free_second_guesses(&seconds);
+        }
+    }
+
+    if (cache_file != NULL && !save_cache(&cache, cache_file))
+        printf("** ERROR: could not save %s **\n", cache_file);
+    if (profiling)
+        print_profile(serve ? stderr : stdout); // stdout carries the protocol in server mode
+    free_cache(&cache);
+    free_word_list(&list);
+    return status;
 }
@@ -0,0 +1,230 @@
+/**
+ * Precomputed decision trees for a fixed first guess, stored in a compact binary file.
+ * Each node is a guess and has one edge per outcome that leaves answers, leading to the next guess.
+ * The file is memory mapped, so following the tree for a turn is a lookup with no parsing.
+ */
+
+#ifndef TREE_C
+#define TREE_C
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "feedback.c"
+
+#define TREE_FILE "tree.bin"      // decision tree file name
+#define TREE_MAGIC "WRDLTRE2"     // identifies a decision tree file
+#define TREE_OUTCOME_BITS 16      // the low bits of an edge hold its outcome code, the rest the node it leads to
+#define TREE_OUTCOME_MASK ((1ULL << TREE_OUTCOME_BITS) - 1)
+
+/**
+ * The header at the start of a decision tree file, followed by the nodes and then the edges.
+ */
+struct tree_header
+{
+    char magic[FEEDBACK_MAGIC_LENGTH]; // TREE_MAGIC
+    int version;                       // STRATEGY_VERSION
+    int opener;                        // the index of the first guess, the guess of node 0
+    int node_count;                    // the number of nodes
+    int edge_count;                    // the number of edges
+    unsigned long long checksum;       // checksum of the words the tree was built from
+};
+
+/**
+ * A node of a decision tree, the guess to make and where its edges are.
+ */
+struct tree_node
+{
+    int guess;               // the index of the guess
+    int child_count;         // the number of edges of this node
+    unsigned int first_edge; // the index of the first edge, edges are sorted by outcome code
+};
+
+/**
+ * A decision tree, either memory mapped from a file or being built.
+ */
+struct decision_tree
+{
+    void *map;                // the mapped file, NULL if the tree isn't mapped
+    size_t map_size;          // the size of the mapped file
+    struct tree_header header;
+    struct tree_node *nodes;
+    unsigned long long *edges; // (node << TREE_OUTCOME_BITS) | outcome
+    int node_capacity;        // the space allocated for nodes while building
+    int edge_capacity;        // the space allocated for edges while building
+};
+
+/**
+ * Check that every index in a mapped decision tree is in range, so following it never reads outside the file.
+ * @param list The word list.
+ * @param header The header of the tree, whose sizes match the file.
+ * @param nodes The nodes of the tree.
+ * @param edges The edges of the tree.
+ * @return Boolean indicating whether the opener and every guess, edge range and child node are valid.
+ */
+bool check_tree(struct word_list *list, struct tree_header *header, struct tree_node *nodes, unsigned long long *edges)
+{
+    if (header->opener < 0 || header->opener >= list->guess_count || nodes[0].guess != header->opener)
+        return false;
+    for (int i = 0; i < header->node_count; i++)
+    {
+        if (nodes[i].guess < 0 || nodes[i].guess >= list->guess_count || nodes[i].child_count < 0 ||
+            (unsigned long long)nodes[i].first_edge + nodes[i].child_count > (unsigned long long)header->edge_count)
+            return false;
+    }
+    for (int i = 0; i < header->edge_count; i++)
+    {
+        if (edges[i] >> TREE_OUTCOME_BITS >= (unsigned long long)header->node_count)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Memory map a decision tree file.
+ * @param tree The tree to load into.
+ * @param file_name The name of the file.
+ * @param list The current word list, the tree is rejected if it was built from different words or has an index out of range.
+ * @return Boolean indicating whether the tree was loaded, if not the tree is left empty.
+ */
+bool load_tree(struct decision_tree *tree, char *file_name, struct word_list *list)
+{
+    memset(tree, 0, sizeof(*tree));
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size >= (off_t)sizeof(struct tree_header))
+        map = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping stays valid after the file is closed
+    if (map == MAP_FAILED)
+        return false;
+
+    struct tree_header *header = map;
+    struct tree_node *nodes = (struct tree_node *)(header + 1);
+    unsigned long long *edges = (unsigned long long *)(nodes + header->node_count);
+    size_t expected_size = sizeof(struct tree_header) + (size_t)header->node_count * sizeof(struct tree_node) +
+                           (size_t)header->edge_count * sizeof(unsigned long long);
+    if (memcmp(header->magic, TREE_MAGIC, FEEDBACK_MAGIC_LENGTH) != 0 || header->version != STRATEGY_VERSION ||
+        header->checksum != list->checksum || header->node_count < 1 || header->edge_count < 0 || expected_size != (size_t)info.st_size ||
+        !check_tree(list, header, nodes, edges)) // checked once here, so following the tree needs no checks
+    {
+        munmap(map, info.st_size);
+        return false;
+    }
+
+    tree->map = map;
+    tree->map_size = info.st_size;
+    tree->header = *header;
+    tree->nodes = nodes;
+    tree->edges = edges;
+    return true;
+}
+
+/**
+ * Release a decision tree, whether it was loaded or built.
+ * @param tree The tree to release.
+ */
+void free_tree(struct decision_tree *tree)
+{
+    if (tree->map != NULL)
+        munmap(tree->map, tree->map_size);
+    else
+    {
+        free(tree->nodes);
+        free(tree->edges);
+    }
+    memset(tree, 0, sizeof(*tree));
+}
+
+/**
+ * Get the root of a decision tree for a first guess.
+ * @param tree The tree, which may be empty.
+ * @param opener The index of the first guess.
+ * @return The root node, or NULL_INDEX if the tree wasn't built for this first guess.
+ */
+int get_tree_root(struct decision_tree *tree, int opener)
+{
+    if (tree->nodes == NULL || tree->header.opener != opener)
+        return NULL_INDEX;
+    return 0;
+}
+
+/**
+ * Follow the edge of a node for an outcome.
+ * @param tree The tree.
+ * @param node The current node.
+ * @param outcome The outcome code given for the node's guess.
+ * @return The next node, or NULL_INDEX if no answers give this outcome.
+ */
+int get_tree_child(struct decision_tree *tree, int node, int outcome)
+{
+    unsigned long long *edges = &tree->edges[tree->nodes[node].first_edge];
+    int low = 0, high = tree->nodes[node].child_count - 1;
+    while (low <= high) // binary search the edges, which are sorted by outcome
+    {
+        int middle = (low + high) / 2;
+        int edge_outcome = edges[middle] & TREE_OUTCOME_MASK;
+        if (edge_outcome == outcome)
+            return edges[middle] >> TREE_OUTCOME_BITS;
+        else if (edge_outcome < outcome)
+            low = middle + 1;
+        else
+            high = middle - 1;
+    }
+    return NULL_INDEX;
+}
+
+/**
+ * Add a node to a tree being built.
+ * @param tree The tree being built.
+ * @param guess The index of the guess of the node.
+ * @param child_count The number of edges the node will have.
+ * @return The index of the new node, its edges are reserved but not yet filled in.
+ */
+int add_tree_node(struct decision_tree *tree, int guess, int child_count)
+{
+    if (tree->header.node_count == tree->node_capacity)
+    {
+        tree->node_capacity = tree->node_capacity > 0 ? tree->node_capacity * 2 : 1024;
+        tree->nodes = realloc(tree->nodes, sizeof(struct tree_node) * tree->node_capacity);
+    }
+    while (tree->header.edge_count + child_count > tree->edge_capacity)
+    {
+        tree->edge_capacity = tree->edge_capacity > 0 ? tree->edge_capacity * 2 : 1024;
+        tree->edges = realloc(tree->edges, sizeof(unsigned long long) * tree->edge_capacity);
+    }
+
+    int node = tree->header.node_count++;
+    tree->nodes[node] = (struct tree_node){.guess = guess, .child_count = child_count, .first_edge = tree->header.edge_count};
+    tree->header.edge_count += child_count;
+    return node;
+}
+
+/**
+ * Save a built decision tree.
+ * @param tree The tree, whose node 0 must be the guess of header.opener.
+ * @param file_name The name of the file to save to.
+ * @param checksum The checksum of the words the tree was built from.
+ * @return Boolean indicating whether the tree was saved.
+ */
+bool save_tree(struct decision_tree *tree, char *file_name, unsigned long long checksum)
+{
+    FILE *f = fopen(file_name, "wb");
+    if (f == NULL)
+        return false;
+
+    memcpy(tree->header.magic, TREE_MAGIC, FEEDBACK_MAGIC_LENGTH);
+    tree->header.version = STRATEGY_VERSION;
+    tree->header.checksum = checksum;
+    bool saved = fwrite(&tree->header, sizeof(tree->header), 1, f) == 1 &&
+                 fwrite(tree->nodes, sizeof(struct tree_node), tree->header.node_count, f) == (size_t)tree->header.node_count &&
+                 fwrite(tree->edges, sizeof(unsigned long long), tree->header.edge_count, f) == (size_t)tree->header.edge_count;
+    return fclose(f) == 0 && saved;
+}
+
+#endif